@@ -0,0 +1,150 @@
+// Lock throughput of adaptive_mutex against spin_mutex and std::mutex, and of the shared variant, as threads pile on
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/adaptive_mutex.h>
+#include <zest/thread/thread_utils.h>
+
+namespace
+{
+
+const auto RunTime = std::chrono::milliseconds(200);
+
+// A little work inside the lock, and a little outside, so the lock isn't just ping-ponged
+struct SharedState
+{
+    uint64_t values[8] = {};
+};
+
+void Work(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        cpu_relax();
+    }
+}
+
+// Every thread runs until the deadline; returns total lock acquisitions per second
+template <class Body>
+double OpsPerSecond(uint32_t threads, Body body)
+{
+    std::atomic<bool> go = false;
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> total = 0;
+
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            while (!go)
+            {
+                std::this_thread::yield();
+            }
+
+            uint64_t ops = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                body(t, ops);
+                ops++;
+            }
+            total += ops;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    std::this_thread::sleep_for(RunTime);
+    stop = true;
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return double(total) / elapsed;
+}
+
+template <class Mutex>
+double ExclusiveOps(uint32_t threads)
+{
+    Mutex mutex;
+    SharedState state;
+    return OpsPerSecond(threads, [&](uint32_t, uint64_t) {
+        {
+            std::lock_guard<Mutex> lock(mutex);
+            for (auto& value : state.values)
+            {
+                value++;
+            }
+        }
+        Work(20);
+    });
+}
+
+// One write in sixteen
+template <class Mutex>
+double SharedOps(uint32_t threads)
+{
+    Mutex mutex;
+    SharedState state;
+    std::atomic<uint64_t> sink = 0;
+    return OpsPerSecond(threads, [&](uint32_t, uint64_t op) {
+        if ((op & 15) == 0)
+        {
+            std::lock_guard<Mutex> lock(mutex);
+            for (auto& value : state.values)
+            {
+                value++;
+            }
+        }
+        else
+        {
+            std::shared_lock<Mutex> lock(mutex);
+            uint64_t sum = 0;
+            for (auto& value : state.values)
+            {
+                sum += value;
+            }
+            sink.store(sum, std::memory_order_relaxed);
+        }
+        Work(20);
+    });
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%8s %14s %14s %14s %18s %18s %10s %10s\n", "threads", "spin/s", "std/s", "adaptive/s", "std shared/s", "adaptive shared/s", "contended", "parks");
+    for (uint32_t threads = 1; threads <= 64; threads *= 2)
+    {
+        auto spin = ExclusiveOps<Zest::spin_mutex>(threads);
+        auto standard = ExclusiveOps<std::mutex>(threads);
+        auto standardShared = SharedOps<std::shared_mutex>(threads);
+        auto adaptiveShared = SharedOps<Zest::adaptive_shared_mutex>(threads);
+
+        // Run the adaptive one again by hand to report how it got in
+        Zest::adaptive_mutex mutex;
+        SharedState state;
+        auto adaptive = OpsPerSecond(threads, [&](uint32_t, uint64_t) {
+            {
+                std::lock_guard<Zest::adaptive_mutex> lock(mutex);
+                for (auto& value : state.values)
+                {
+                    value++;
+                }
+            }
+            Work(20);
+        });
+        auto stats = mutex.stats();
+
+        std::printf("%8u %14.0f %14.0f %14.0f %18.0f %18.0f %9.1f%% %10llu\n", threads, spin, standard, adaptive, standardShared, adaptiveShared,
+            stats.ContendedFraction() * 100.0, (unsigned long long)stats.parks);
+    }
+    return 0;
+}
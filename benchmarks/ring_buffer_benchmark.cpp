@@ -0,0 +1,109 @@
+// Throughput of ring_buffer one item at a time against the bulk functions, on audio sized windows, and of
+// mirrored_ring_buffer, which reads each window in place as one span
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include <zest/algorithm/mirrored_ring_buffer.h>
+#include <zest/algorithm/ring_buffer.h>
+
+namespace
+{
+
+const uint32_t Capacity = 1 << 20;
+const size_t Block = 4096;
+const size_t TotalSamples = size_t(256) << 20;
+
+template <class Fn>
+double SamplesPerSecond(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return double(TotalSamples) / elapsed;
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<float> in(Block);
+    std::iota(in.begin(), in.end(), 0.0f);
+    std::vector<float> out(Block);
+
+    Zest::ring_buffer<float> buffer;
+    Zest::ring_buffer_init(buffer, Capacity);
+
+    float sink = 0.0f;
+    auto single = SamplesPerSecond([&]() {
+        for (size_t done = 0; done < TotalSamples; done += Block)
+        {
+            for (auto sample : in)
+            {
+                Zest::ring_buffer_add(buffer, sample);
+            }
+            for (size_t i = 0; i < Block; i++)
+            {
+                out[i] = Zest::ring_buffer_drain(buffer);
+            }
+            sink += out[Block - 1];
+        }
+    });
+
+    auto bulk = SamplesPerSecond([&]() {
+        for (size_t done = 0; done < TotalSamples; done += Block)
+        {
+            Zest::ring_buffer_push_n(buffer, in);
+            Zest::ring_buffer_pop_n(buffer, out);
+            sink += out[Block - 1];
+        }
+    });
+
+    // Sum the newest window in place each block, as an analysis pass would
+    auto windowed = SamplesPerSecond([&]() {
+        for (size_t done = 0; done < TotalSamples; done += Block)
+        {
+            Zest::ring_buffer_push_n(buffer, in);
+            auto window = Zest::ring_buffer_view_newest(buffer, Block);
+            for (auto segment : { window.first, window.second })
+            {
+                for (auto sample : segment)
+                {
+                    sink += sample;
+                }
+            }
+        }
+    });
+
+    Zest::mirrored_ring_buffer<float> mirrored;
+    Zest::mirrored_ring_buffer_init(mirrored, Capacity);
+    auto mirroredBulk = SamplesPerSecond([&]() {
+        for (size_t done = 0; done < TotalSamples; done += Block)
+        {
+            Zest::mirrored_ring_buffer_push_n(mirrored, in);
+            Zest::mirrored_ring_buffer_pop_n(mirrored, out);
+            sink += out[Block - 1];
+        }
+    });
+
+    auto mirroredWindowed = SamplesPerSecond([&]() {
+        for (size_t done = 0; done < TotalSamples; done += Block)
+        {
+            Zest::mirrored_ring_buffer_push_n(mirrored, in);
+            for (auto sample : Zest::mirrored_ring_buffer_view_newest(mirrored, Block))
+            {
+                sink += sample;
+            }
+        }
+    });
+
+    // Bytes are counted once in and once out
+    std::printf("%16s %16s %16s\n", "", "samples/s", "GB/s");
+    std::printf("%16s %16.0f %16.2f\n", "single", single, single * sizeof(float) * 2 / 1e9);
+    std::printf("%16s %16.0f %16.2f\n", "bulk", bulk, bulk * sizeof(float) * 2 / 1e9);
+    std::printf("%16s %16.0f %16.2f\n", "windowed", windowed, windowed * sizeof(float) * 2 / 1e9);
+    std::printf("%16s %16.0f %16.2f\n", "mirrored bulk", mirroredBulk, mirroredBulk * sizeof(float) * 2 / 1e9);
+    std::printf("%16s %16.0f %16.2f\n", "mirrored window", mirroredWindowed, mirroredWindowed * sizeof(float) * 2 / 1e9);
+    return sink < 0.0f ? 1 : 0;
+}
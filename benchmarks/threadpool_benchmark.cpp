@@ -0,0 +1,206 @@
+// Small task throughput of the work stealing TPool against the original single queue pool
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/thread_utils.h>
+#include <zest/thread/threadpool.h>
+
+namespace
+{
+
+// The pool as it was before work stealing; one queue, one lock, one condition variable
+class LegacyPool
+{
+public:
+    LegacyPool(size_t threads)
+    {
+        for (; threads; --threads)
+        {
+            m_workers.emplace_back([this] {
+                while (true)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                        if (m_stop && m_tasks.empty())
+                            return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~LegacyPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        for (auto& worker : m_workers)
+            worker.join();
+    }
+
+    template <class F>
+    std::future<void> enqueue(F&& f)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+        auto res = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]() { (*task)(); });
+        }
+        m_condition.notify_one();
+        return res;
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+};
+
+const uint32_t FlatTasks = 1 << 18;
+const uint32_t TreeDepth = 17;
+
+void WaitFor(const std::atomic<uint32_t>& counter, uint32_t target)
+{
+    while (counter.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::yield();
+    }
+}
+
+// Many tiny tasks submitted from the main thread
+template <typename Pool>
+double FlatTasksPerSecond(Pool& pool)
+{
+    std::atomic<uint32_t> done = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t index = 0; index < FlatTasks; index++)
+    {
+        (void)pool.enqueue([&done]() {
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(done, FlatTasks);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return FlatTasks / seconds;
+}
+
+// The same tasks through fire and forget submission
+double SubmitTasksPerSecond(TPool& pool)
+{
+    std::atomic<uint32_t> done = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t index = 0; index < FlatTasks; index++)
+    {
+        pool.submit([&done]() {
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(done, FlatTasks);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return FlatTasks / seconds;
+}
+
+// And in batches; one lock and one wakeup per batch
+double BatchTasksPerSecond(TPool& pool)
+{
+    const uint32_t BatchSize = 256;
+    std::atomic<uint32_t> done = 0;
+    std::vector<Zest::job> batch(BatchSize);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t index = 0; index < FlatTasks; index += BatchSize)
+    {
+        for (auto& fn : batch)
+        {
+            fn = Zest::job([&done]() {
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        pool.submit_batch(batch);
+    }
+    WaitFor(done, FlatTasks);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return FlatTasks / seconds;
+}
+
+// Tasks which split into two children, so most work is submitted from inside the pool
+template <typename Pool>
+void Spawn(Pool& pool, std::atomic<uint32_t>& done, uint32_t depth)
+{
+    done.fetch_add(1, std::memory_order_release);
+    if (depth == 0)
+    {
+        return;
+    }
+    for (int child = 0; child < 2; child++)
+    {
+        (void)pool.enqueue([&pool, &done, depth]() {
+            Spawn(pool, done, depth - 1);
+        });
+    }
+}
+
+template <typename Pool>
+double TreeTasksPerSecond(Pool& pool)
+{
+    const uint32_t total = (1u << (TreeDepth + 1)) - 1;
+    std::atomic<uint32_t> done = 0;
+    auto start = std::chrono::steady_clock::now();
+    (void)pool.enqueue([&pool, &done]() {
+        Spawn(pool, done, TreeDepth);
+    });
+    WaitFor(done, total);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total / seconds;
+}
+
+} // namespace
+
+int main()
+{
+    const auto maxThreads = std::max(2u, std::thread::hardware_concurrency());
+
+    std::printf("%8s %16s %16s %16s %16s %16s %16s\n", "threads", "legacy flat/s", "tpool flat/s", "submit/s", "batch/s", "legacy tree/s", "tpool tree/s");
+    for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        double legacyFlat, legacyTree, poolFlat, poolSubmit, poolBatch, poolTree;
+        {
+            LegacyPool pool(threads);
+            legacyFlat = FlatTasksPerSecond(pool);
+            legacyTree = TreeTasksPerSecond(pool);
+        }
+        {
+            TPool pool(threads);
+            poolFlat = FlatTasksPerSecond(pool);
+            poolSubmit = SubmitTasksPerSecond(pool);
+            poolBatch = BatchTasksPerSecond(pool);
+            poolTree = TreeTasksPerSecond(pool);
+        }
+        std::printf("%8u %16.0f %16.0f %16.0f %16.0f %16.0f %16.0f\n", threads, legacyFlat, poolFlat, poolSubmit, poolBatch, legacyTree, poolTree);
+
+        if (threads < maxThreads && threads * 2 > maxThreads)
+        {
+            threads = maxThreads / 2;
+        }
+    }
+    return 0;
+}
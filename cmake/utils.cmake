@@ -28,6 +28,27 @@ function (exclude_files_from_dir_in_list _InFileList _excludeDirName _verbose)
   set(SOURCE_FILES ${_InFileList} PARENT_SCOPE)                          # Return the SOURCE_FILES variable to the calling parent
 endfunction (exclude_files_from_dir_in_list)
 
+# Function:                 ZEST_INSTRUMENT_TARGET
+# Description:              Compile a target with -finstrument-functions, so every function is recorded by the
+#                           profiler (needs ZEST_PROFILE_INSTRUMENT).  Standard headers are skipped on GCC, and
+#                           symbols are exported so the hooks can name the functions.
+# Param _target:            The target to instrument
+function (zest_instrument_target _target)
+  if (MSVC)
+    message(WARNING "zest_instrument_target: ${_target} not instrumented, MSVC has no -finstrument-functions")
+    return()
+  endif()
+
+  target_compile_options(${_target} PRIVATE -finstrument-functions)
+  if (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    target_compile_options(${_target} PRIVATE -finstrument-functions-exclude-file-list=/c++/,/bits/,/include/zest/)
+  endif()
+
+  if ("${CMAKE_SYSTEM_NAME}" STREQUAL "Linux")
+    target_link_options(${_target} PUBLIC -rdynamic)
+  endif()
+endfunction (zest_instrument_target)
+
 macro(copy_existing_files TARGET_PROJECT GLOBPAT DESTINATION)
   file(GLOB COPY_FILES
     ${GLOBPAT})
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Zest
+{
+
+// size bytes, followed immediately by the same bytes again. On Linux the second half is the same memfd pages
+// mapped a second time; elsewhere (or if mapping fails) it is a plain copy that writers must keep up to date
+struct mirrored_memory
+{
+    uint8_t* pData = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+// Page size; mirrored sizes are a power of two multiple of it
+size_t mirrored_memory_granularity();
+
+// Rounds minSize up to a power of two, at least one page
+bool mirrored_memory_alloc(mirrored_memory& memory, size_t minSize);
+void mirrored_memory_free(mirrored_memory& memory);
+
+// ring_buffer with contiguous wrap-around: any run of up to capacity items, starting anywhere, is one pointer.
+// Readers (DSP kernels, write() calls) can use a view directly instead of handling two segments.
+// Same semantics and functions as ring_buffer: it keeps the newest capacity items, dropping the oldest
+template <class T>
+struct mirrored_ring_buffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Items are copied as bytes");
+    static_assert(std::has_single_bit(sizeof(T)), "Items must tile the pages exactly");
+
+    mirrored_ring_buffer() = default;
+    mirrored_ring_buffer(const mirrored_ring_buffer&) = delete;
+    mirrored_ring_buffer& operator=(const mirrored_ring_buffer&) = delete;
+
+    ~mirrored_ring_buffer()
+    {
+        mirrored_memory_free(memory);
+    }
+
+    mirrored_memory memory;
+    T* pData = nullptr;
+    size_t count = 0; // Items in one copy of the storage
+    size_t head = 0;
+    size_t tail = 0;
+    uint32_t capacity = 0;
+};
+
+namespace detail
+{
+
+// Copy in at an index; the unmapped fallback writes both halves
+template <class T>
+void mirrored_ring_buffer_write(mirrored_ring_buffer<T>& buffer, size_t index, std::span<const T> items)
+{
+    const auto offset = index & (buffer.count - 1);
+    std::memcpy(buffer.pData + offset, items.data(), items.size_bytes());
+    if (!buffer.memory.mapped)
+    {
+        // Whatever went past the end belongs at the start, and the rest belongs in the second half
+        const auto first = std::min(items.size(), buffer.count - offset);
+        std::memcpy(buffer.pData + offset + buffer.count, items.data(), first * sizeof(T));
+        std::memcpy(buffer.pData, items.data() + first, (items.size() - first) * sizeof(T));
+    }
+}
+
+} // namespace detail
+
+template <class T>
+bool mirrored_ring_buffer_init(mirrored_ring_buffer<T>& buffer, uint32_t capacity)
+{
+    mirrored_memory_free(buffer.memory);
+    if (!mirrored_memory_alloc(buffer.memory, std::max<size_t>(capacity, 1) * sizeof(T)))
+    {
+        buffer.pData = nullptr;
+        buffer.count = 0;
+        buffer.capacity = 0;
+        return false;
+    }
+
+    buffer.pData = reinterpret_cast<T*>(buffer.memory.pData);
+    buffer.count = buffer.memory.size / sizeof(T);
+    buffer.capacity = capacity;
+    buffer.tail = buffer.head = 0U;
+    return true;
+}
+
+template <class T>
+bool mirrored_ring_buffer_empty(const mirrored_ring_buffer<T>& buffer)
+{
+    return buffer.head == buffer.tail;
+}
+
+template <class T>
+size_t mirrored_ring_buffer_size(const mirrored_ring_buffer<T>& buffer)
+{
+    return buffer.head - buffer.tail;
+}
+
+// The contents, oldest first, in one piece
+template <class T>
+std::span<T> mirrored_ring_buffer_view(mirrored_ring_buffer<T>& buffer)
+{
+    return std::span<T>(buffer.pData + (buffer.tail & (buffer.count - 1)), mirrored_ring_buffer_size(buffer));
+}
+
+template <class T>
+std::span<const T> mirrored_ring_buffer_view(const mirrored_ring_buffer<T>& buffer)
+{
+    return std::span<const T>(buffer.pData + (buffer.tail & (buffer.count - 1)), mirrored_ring_buffer_size(buffer));
+}
+
+// The newest count items (or all of them, if fewer), oldest first
+template <class T>
+std::span<const T> mirrored_ring_buffer_view_newest(const mirrored_ring_buffer<T>& buffer, size_t count)
+{
+    count = std::min(count, mirrored_ring_buffer_size(buffer));
+    return std::span<const T>(buffer.pData + ((buffer.head - count) & (buffer.count - 1)), count);
+}
+
+template <class T>
+void mirrored_ring_buffer_add(mirrored_ring_buffer<T>& buffer, const T& item)
+{
+    detail::mirrored_ring_buffer_write(buffer, buffer.head, std::span<const T>(&item, 1));
+    buffer.head++;
+    if (buffer.head - buffer.tail > buffer.capacity)
+    {
+        // Drop oldest entry, keep the rest
+        buffer.tail++;
+    }
+}
+
+template <class T>
+const T mirrored_ring_buffer_drain(mirrored_ring_buffer<T>& buffer)
+{
+    assert(!mirrored_ring_buffer_empty(buffer));
+    return buffer.pData[buffer.tail++ & (buffer.count - 1)];
+}
+
+// Add many, dropping the oldest to make room
+template <class T>
+void mirrored_ring_buffer_push_n(mirrored_ring_buffer<T>& buffer, std::type_identity_t<std::span<const T>> items)
+{
+    if (items.size() > buffer.capacity)
+    {
+        items = items.subspan(items.size() - buffer.capacity);
+    }
+
+    detail::mirrored_ring_buffer_write(buffer, buffer.head, items);
+    buffer.head += items.size();
+    if (buffer.head - buffer.tail > buffer.capacity)
+    {
+        buffer.tail = buffer.head - buffer.capacity;
+    }
+}
+
+// Copy out the oldest items without removing them, skipping offset first; returns the count copied
+template <class T>
+size_t mirrored_ring_buffer_peek_n(const mirrored_ring_buffer<T>& buffer, std::type_identity_t<std::span<T>> dest, size_t offset = 0)
+{
+    auto items = mirrored_ring_buffer_view(buffer);
+    if (offset >= items.size())
+    {
+        return 0;
+    }
+
+    items = items.subspan(offset, std::min(dest.size(), items.size() - offset));
+    std::memcpy(dest.data(), items.data(), items.size_bytes());
+    return items.size();
+}
+
+// Remove the oldest items into dest; returns the count removed
+template <class T>
+size_t mirrored_ring_buffer_pop_n(mirrored_ring_buffer<T>& buffer, std::type_identity_t<std::span<T>> dest)
+{
+    auto count = mirrored_ring_buffer_peek_n(buffer, dest);
+    buffer.tail += count;
+    return count;
+}
+
+template <class T>
+void mirrored_ring_buffer_assign_ordered(const mirrored_ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+{
+    dest.resize(count);
+    count = std::min<uint32_t>(count, uint32_t(buffer.count));
+    std::memcpy(dest.data(), buffer.pData + (buffer.tail & (buffer.count - 1)), count * sizeof(T));
+}
+
+// The newest count items, oldest first
+template <class T>
+void mirrored_ring_buffer_assign_ordered_newest(const mirrored_ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+{
+    dest.resize(count);
+    count = std::min<uint32_t>(count, uint32_t(buffer.count));
+    std::memcpy(dest.data(), buffer.pData + ((buffer.head - count) & (buffer.count - 1)), count * sizeof(T));
+}
+
+template <class T>
+void mirrored_ring_buffer_drain_n(mirrored_ring_buffer<T>& buffer, uint32_t count)
+{
+    buffer.tail += std::min<size_t>(count, mirrored_ring_buffer_size(buffer));
+}
+
+} // namespace Zest
@@ -1,25 +1,133 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <compare>
 #include <cstdint>
+#include <iterator>
+#include <span>
+#include <type_traits>
 #include <vector>
 
 namespace Zest
 {
 
+// A run of ring storage (contents or free space) as at most two contiguous pieces, in order
+template <class T>
+struct ring_span
+{
+    std::span<T> first;
+    std::span<T> second;
+
+    size_t size() const
+    {
+        return first.size() + second.size();
+    }
+
+    bool empty() const
+    {
+        return first.empty() && second.empty();
+    }
+
+    // Copy out in order; dest must hold size() items
+    template <class U>
+    void copy_to(std::span<U> dest) const
+    {
+        assert(dest.size() >= size());
+        std::copy(first.begin(), first.end(), dest.begin());
+        std::copy(second.begin(), second.end(), dest.begin() + first.size());
+    }
+};
+
+// Keeps the newest capacity items; adding to a full buffer drops the oldest.
+// head and tail count up forever and are masked into data, whose size is a power of two
 template <class T>
 struct ring_buffer
 {
     std::vector<T> data;
-    size_t head;
-    size_t tail;
-    uint32_t capacity;
+    size_t head = 0;
+    size_t tail = 0;
+    uint32_t capacity = 0;
+
+    // Oldest to newest
+    template <class Value>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using iterator_concept = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        basic_iterator() = default;
+        basic_iterator(Value* pData, size_t mask, size_t index)
+            : m_pData(pData)
+            , m_mask(mask)
+            , m_index(index)
+        {
+        }
+
+        // iterator to const_iterator
+        operator basic_iterator<const Value>() const
+            requires(!std::is_const_v<Value>)
+        {
+            return basic_iterator<const Value>(m_pData, m_mask, m_index);
+        }
+
+        reference operator*() const { return m_pData[m_index & m_mask]; }
+        pointer operator->() const { return &m_pData[m_index & m_mask]; }
+        reference operator[](difference_type offset) const { return m_pData[(m_index + offset) & m_mask]; }
+
+        basic_iterator& operator++() { ++m_index; return *this; }
+        basic_iterator operator++(int) { auto it = *this; ++m_index; return it; }
+        basic_iterator& operator--() { --m_index; return *this; }
+        basic_iterator operator--(int) { auto it = *this; --m_index; return it; }
+        basic_iterator& operator+=(difference_type offset) { m_index += offset; return *this; }
+        basic_iterator& operator-=(difference_type offset) { m_index -= offset; return *this; }
+        basic_iterator operator+(difference_type offset) const { return basic_iterator(m_pData, m_mask, m_index + offset); }
+        basic_iterator operator-(difference_type offset) const { return basic_iterator(m_pData, m_mask, m_index - offset); }
+        friend basic_iterator operator+(difference_type offset, const basic_iterator& it) { return it + offset; }
+        difference_type operator-(const basic_iterator& rhs) const { return difference_type(m_index - rhs.m_index); }
+
+        bool operator==(const basic_iterator& rhs) const { return m_index == rhs.m_index; }
+        auto operator<=>(const basic_iterator& rhs) const { return difference_type(m_index - rhs.m_index) <=> 0; }
+
+    private:
+        Value* m_pData = nullptr;
+        size_t m_mask = 0;
+        size_t m_index = 0;
+    };
+
+    using iterator = basic_iterator<T>;
+    using const_iterator = basic_iterator<const T>;
+
+    iterator begin() { return iterator(data.data(), data.size() - 1, tail); }
+    iterator end() { return iterator(data.data(), data.size() - 1, head); }
+    const_iterator begin() const { return const_iterator(data.data(), data.size() - 1, tail); }
+    const_iterator end() const { return const_iterator(data.data(), data.size() - 1, head); }
 };
 
+namespace detail
+{
+
+template <class T, class Data>
+ring_span<T> ring_buffer_segments(Data& data, size_t start, size_t count)
+{
+    const auto offset = start & (data.size() - 1);
+    const auto first = std::min(count, data.size() - offset);
+    return { std::span<T>(data.data() + offset, first), std::span<T>(data.data(), count - first) };
+}
+
+} // namespace detail
+
 template <class T>
 void ring_buffer_init(ring_buffer<T>& buffer, uint32_t capacity)
 {
     buffer.capacity = capacity;
-    buffer.data.resize(capacity + 1);
+    buffer.data.resize(std::bit_ceil(std::max(capacity, 1u)));
     buffer.tail = buffer.head = 0U;
 }
 
@@ -32,18 +140,18 @@ bool ring_buffer_empty(const ring_buffer<T>& buffer)
 template <class T>
 size_t ring_buffer_size(const ring_buffer<T>& buffer)
 {
-    return (buffer.head >= buffer.tail) ? (buffer.head - buffer.tail) : (buffer.data.size() - (buffer.tail - buffer.head));
+    return buffer.head - buffer.tail;
 }
 
 template <class T>
 void ring_buffer_add(ring_buffer<T>& buffer, const T& item)
 {
-    buffer.data[buffer.head] = item;
-    buffer.head = (buffer.head + 1) % buffer.data.size();
-    if (buffer.head == buffer.tail)
+    buffer.data[buffer.head & (buffer.data.size() - 1)] = item;
+    buffer.head++;
+    if (buffer.head - buffer.tail > buffer.capacity)
     {
         // Drop oldest entry, keep the rest
-        buffer.tail = (buffer.tail + 1) % buffer.data.size();
+        buffer.tail++;
     }
 }
 
@@ -51,33 +159,91 @@ template <class T>
 const T ring_buffer_drain(ring_buffer<T>& buffer)
 {
     assert(!ring_buffer_empty(buffer));
-    size_t old_tail = buffer.tail;
-    buffer.tail = (buffer.tail + 1) % buffer.data.size();
-    return buffer.data[old_tail];
+    return buffer.data[buffer.tail++ & (buffer.data.size() - 1)];
 }
 
+// The contents, oldest first, as at most two contiguous runs
 template <class T>
-void ring_buffer_assign_ordered(const ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+ring_span<T> ring_buffer_view(ring_buffer<T>& buffer)
 {
-    dest.resize(count);
-    size_t idx = buffer.tail;
-    for (uint32_t i = 0; i < count; ++i)
+    return detail::ring_buffer_segments<T>(buffer.data, buffer.tail, ring_buffer_size(buffer));
+}
+
+template <class T>
+ring_span<const T> ring_buffer_view(const ring_buffer<T>& buffer)
+{
+    return detail::ring_buffer_segments<const T>(buffer.data, buffer.tail, ring_buffer_size(buffer));
+}
+
+// The newest count items (or all of them, if fewer), oldest first
+template <class T>
+ring_span<const T> ring_buffer_view_newest(const ring_buffer<T>& buffer, size_t count)
+{
+    count = std::min(count, ring_buffer_size(buffer));
+    return detail::ring_buffer_segments<const T>(buffer.data, buffer.head - count, count);
+}
+
+// Add many; as with ring_buffer_add the oldest are dropped to make room. Copies at most two runs
+template <class T>
+void ring_buffer_push_n(ring_buffer<T>& buffer, std::type_identity_t<std::span<const T>> items)
+{
+    // Only the newest capacity items can survive
+    if (items.size() > buffer.capacity)
+    {
+        items = items.subspan(items.size() - buffer.capacity);
+    }
+
+    auto space = detail::ring_buffer_segments<T>(buffer.data, buffer.head, items.size());
+    std::copy_n(items.begin(), space.first.size(), space.first.begin());
+    std::copy_n(items.begin() + space.first.size(), space.second.size(), space.second.begin());
+
+    buffer.head += items.size();
+    if (buffer.head - buffer.tail > buffer.capacity)
     {
-        dest[i] = buffer.data[idx];
-        idx = (idx + 1) % buffer.data.size();
+        buffer.tail = buffer.head - buffer.capacity;
     }
 }
 
+// Copy out the oldest items without removing them, skipping offset first; returns the count copied
 template <class T>
-void ring_buffer_assign_ordered_newest(const ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+size_t ring_buffer_peek_n(const ring_buffer<T>& buffer, std::type_identity_t<std::span<T>> dest, size_t offset = 0)
 {
-    dest.resize(count);
-    size_t idx = buffer.head;
-    for (uint32_t i = 0; i < count; ++i)
+    const auto size = ring_buffer_size(buffer);
+    if (offset >= size)
     {
-        dest[i] = buffer.data[idx];
-        idx = (idx + 1) % buffer.data.size();
+        return 0;
     }
+
+    auto items = detail::ring_buffer_segments<const T>(buffer.data, buffer.tail + offset, std::min(dest.size(), size - offset));
+    items.copy_to(dest);
+    return items.size();
+}
+
+// Remove the oldest items into dest; returns the count removed
+template <class T>
+size_t ring_buffer_pop_n(ring_buffer<T>& buffer, std::type_identity_t<std::span<T>> dest)
+{
+    auto count = ring_buffer_peek_n(buffer, dest);
+    buffer.tail += count;
+    return count;
+}
+
+template <class T>
+void ring_buffer_assign_ordered(const ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+{
+    dest.resize(count);
+    auto items = detail::ring_buffer_segments<const T>(buffer.data, buffer.tail, std::min<size_t>(count, buffer.data.size()));
+    items.copy_to(std::span<T>(dest));
+}
+
+// The newest count items, oldest first
+template <class T>
+void ring_buffer_assign_ordered_newest(const ring_buffer<T>& buffer, std::vector<T>& dest, uint32_t count)
+{
+    dest.resize(count);
+    count = std::min<uint32_t>(count, uint32_t(buffer.data.size()));
+    auto items = detail::ring_buffer_segments<const T>(buffer.data, buffer.head - count, count);
+    items.copy_to(std::span<T>(dest));
 }
 
 template <class T>
@@ -87,7 +253,7 @@ void ring_buffer_drain_n(ring_buffer<T>& buffer, uint32_t count)
         return;
     const size_t available = ring_buffer_size(buffer);
     const size_t toDrain = std::min<size_t>(count, available);
-    buffer.tail = (buffer.tail + toDrain) % buffer.data.size();
+    buffer.tail += toDrain;
 }
 
 } //namespace Zest
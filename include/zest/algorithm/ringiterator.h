@@ -1,77 +1,189 @@
 #pragma once
-#include <vector>
-#include <string>
+#include <algorithm>
 #include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace Zest
 {
 
-template <typename T, typename Container = std::vector<T>, typename Iterator = Container::iterator>
+// Random access iterator that walks a container (or a [begin, end) range of it) as a ring.
+// Positions are unwrapped: it + size() has gone round once, so it is not equal to it; a window of count items
+// from anywhere in the ring is [it, it + count). Offsets and differences are O(1), so std::ranges algorithms
+// (sort, lower_bound, distance...) over a wrapped window cost the same as over a plain array.
+// Use a const Container (see ConstRingIterator) for read only access.
+template <typename T, typename Container = std::vector<T>, typename Iterator = decltype(std::declval<Container&>().begin())>
 class RingIterator
 {
 public:
-    using difference_type = size_t;
-    using value_type = T;
-    using pointer = T * ;
-    using reference = T & ;
-    using iterator_category = std::bidirectional_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<T>;
+    using pointer = T*;
+    using reference = T&;
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
 
 private:
-    Container& data;
-    Iterator   cursor;
-    Iterator   begin;
-    Iterator   end;
+    template <typename, typename, typename>
+    friend class RingIterator;
+
+    Container* m_pData = nullptr;
+    Iterator m_begin{};
+    difference_type m_size = 0;
+    difference_type m_index = 0;  // Unwrapped position
+    difference_type m_offset = 0; // m_index wrapped into [0, m_size)
+
+    void wrap()
+    {
+        if (m_offset >= m_size || m_offset < 0)
+        {
+            m_offset = m_size ? m_index % m_size : 0;
+            if (m_offset < 0)
+            {
+                m_offset += m_size;
+            }
+        }
+    }
 
 public:
-    RingIterator(Container& v) : data(v), cursor(v.begin()), begin(v.begin()), end(v.end()) {}
-    RingIterator(Container& v, const Iterator& i) : data(v), cursor(i), begin(v.begin()), end(v.end()) {}
-    RingIterator(Container& v, const Iterator& i, const Iterator& j) : data(v), cursor(i), begin(i), end(j) {}
-    RingIterator(Container& v, size_t i) : data(v), cursor(v.begin() + i % v.size()), begin(v.begin()), end(v.end()) {}
-    RingIterator(const RingIterator& r)
-        : data(r.data)
+    RingIterator() = default;
+    RingIterator(Container& v)
+        : RingIterator(v, v.begin(), v.end())
+    {
+    }
+    RingIterator(Container& v, const Iterator& i)
+        : RingIterator(v, v.begin(), v.end())
+    {
+        *this += std::distance(m_begin, i);
+    }
+    RingIterator(Container& v, const Iterator& i, const Iterator& j)
+        : m_pData(std::addressof(v))
+        , m_begin(i)
+        , m_size(std::distance(i, j))
+    {
+    }
+    RingIterator(Container& v, size_t i)
+        : RingIterator(v, v.begin(), v.end())
+    {
+        *this += difference_type(i);
+    }
+
+    // Non-const to const
+    template <typename U, typename C, typename I>
+        requires(!std::is_same_v<RingIterator<U, C, I>, RingIterator> && std::is_convertible_v<C*, Container*> && std::is_convertible_v<I, Iterator>)
+    RingIterator(const RingIterator<U, C, I>& other)
+        : m_pData(other.m_pData)
+        , m_begin(other.m_begin)
+        , m_size(other.m_size)
+        , m_index(other.m_index)
+        , m_offset(other.m_offset)
     {
-        *this = r;
     }
 
+    // The position in the underlying container, and the ring it wraps in
+    Iterator base() const { return m_begin + m_offset; }
+    Iterator ring_begin() const { return m_begin; }
+    difference_type ring_size() const { return m_size; }
+    difference_type offset() const { return m_offset; }
 
-    const RingIterator& operator = (const RingIterator& rhs) 
+    bool operator==(const RingIterator& x) const { return m_index == x.m_index; }
+    std::strong_ordering operator<=>(const RingIterator& x) const { return m_index <=> x.m_index; }
+
+    reference operator*() const { return m_begin[m_offset]; }
+    pointer operator->() const { return std::addressof(**this); }
+    reference operator[](difference_type count) const { return *(*this + count); }
+
+    RingIterator& operator++()
     {
-        assert(&rhs.data == &data);
-        cursor = rhs.cursor;
-        begin = rhs.begin;
-        end = rhs.end;
+        ++m_index;
+        if (++m_offset == m_size)
+        {
+            m_offset = 0;
+        }
         return *this;
     }
-    
-    bool operator == (const RingIterator& x) const { return cursor == x.cursor; }
-    bool operator != (const RingIterator& x) const { return !(*this == x); }
-    reference operator*() const { return *cursor; }
-    RingIterator& operator++() { ++cursor; if (cursor == end) cursor = begin; return *this; }
-    RingIterator& operator+(size_t count) { while (count-- > 0) { (*this)++; } return *this; }
-    RingIterator& operator-(size_t count) { while (count-- > 0) { (*this)--; } return *this; }
     RingIterator operator++(int) { RingIterator ring = *this; ++*this; return ring; }
-    RingIterator& operator--() { if (cursor == begin) cursor = end; --cursor; return *this; }
-    RingIterator operator--(int) { RingIterator ring = *this; --*this; return ring; }
-    RingIterator insert(const T& x) { return RingIterator(data, data.insert(cursor, x)); }
-    RingIterator erase() { return RingIterator(data, data.erase(cursor)); }
-    RingIterator insertAfter(const T& x) 
+    RingIterator& operator--()
     {
-        if (cursor != end)
-        {
-            return RingIterator(data, data.insert(++cursor, x));
-        }
-        else
+        --m_index;
+        if (m_offset-- == 0)
         {
-            return RingIterator(data, data.insert(cursor, x));
+            m_offset = m_size - 1;
         }
+        return *this;
+    }
+    RingIterator operator--(int) { RingIterator ring = *this; --*this; return ring; }
+
+    RingIterator& operator+=(difference_type count)
+    {
+        m_index += count;
+        m_offset += count;
+        wrap();
+        return *this;
+    }
+    RingIterator& operator-=(difference_type count) { return *this += -count; }
+    RingIterator operator+(difference_type count) const { RingIterator ring = *this; return ring += count; }
+    RingIterator operator-(difference_type count) const { RingIterator ring = *this; return ring -= count; }
+    friend RingIterator operator+(difference_type count, const RingIterator& ring) { return ring + count; }
+    difference_type operator-(const RingIterator& x) const { return m_index - x.m_index; }
+
+    RingIterator insert(const T& x) { return RingIterator(*m_pData, m_pData->insert(base(), x)); }
+    RingIterator erase() { return RingIterator(*m_pData, m_pData->erase(base())); }
+    RingIterator insertAfter(const T& x)
+    {
+        // After the last item is the end, not the start again
+        return RingIterator(*m_pData, m_pData->insert(m_begin + std::min(m_offset + 1, m_size), x));
     }
 };
 
-//using ringItr = RingIterator<char, std::string>;
-//using ringItrVec = RingIterator<std::string, std::vector<std::string>>;
-//using ringItrInt = RingIterator<int, std::vector<int>>;
-//
-//
-//
-} // Zest
+template <typename T, typename Container = std::vector<T>>
+using ConstRingIterator = RingIterator<const T, const Container>;
+
+// count items of a container, starting at start and wrapping at the end, as a random access range
+template <typename T, typename Container = std::vector<T>>
+class RingView : public std::ranges::view_interface<RingView<T, Container>>
+{
+public:
+    using iterator = RingIterator<T, Container>;
+    using base_iterator = decltype(std::declval<Container&>().begin());
+
+    RingView() = default;
+    RingView(Container& v, size_t start, size_t count)
+        : m_begin(v, start)
+        , m_count(std::ptrdiff_t(count))
+    {
+    }
+
+    iterator begin() const { return m_begin; }
+    iterator end() const { return m_begin + m_count; }
+    size_t size() const { return size_t(m_count); }
+
+    // The same items as at most two runs of the container, for code that wants plain iterators (or pointers).
+    // Only whole windows (count <= ring size) split cleanly
+    std::pair<std::ranges::subrange<base_iterator>, std::ranges::subrange<base_iterator>> segments() const
+    {
+        assert(m_count <= m_begin.ring_size());
+        auto first = std::min(m_count, m_begin.ring_size() - m_begin.offset());
+        return { { m_begin.base(), m_begin.base() + first }, { m_begin.ring_begin(), m_begin.ring_begin() + (m_count - first) } };
+    }
+
+private:
+    iterator m_begin;
+    std::ptrdiff_t m_count = 0;
+};
+
+template <typename Container>
+RingView(Container&, size_t, size_t) -> RingView<std::remove_reference_t<decltype(*std::declval<Container&>().begin())>, Container>;
+
+} // namespace Zest
 
+// Iterators point into the container, not the view
+template <typename T, typename Container>
+inline constexpr bool std::ranges::enable_borrowed_range<Zest::RingView<T, Container>> = true;
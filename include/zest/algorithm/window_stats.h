@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <zest/algorithm/ring_buffer.h>
+
+namespace Zest
+{
+
+namespace detail
+{
+
+// Fixed size deque of sample sequence numbers, for the monotonic min/max queues. Never holds more than the window
+struct window_queue
+{
+    std::vector<uint64_t> items;
+    uint64_t front = 0;
+    uint64_t back = 0;
+
+    bool empty() const { return front == back; }
+    uint64_t first() const { return items[front & (items.size() - 1)]; }
+    uint64_t last() const { return items[(back - 1) & (items.size() - 1)]; }
+    void push(uint64_t sequence) { items[back++ & (items.size() - 1)] = sequence; }
+};
+
+} // namespace detail
+
+// Rolling min, max, mean, variance and approximate percentiles of the newest capacity samples, for frame times,
+// levels and the like. Every add is O(1) (amortized, for min/max), and nothing is recomputed over the window:
+// - min/max come from monotonic queues, whose fronts are the answer
+// - mean/variance come from running sums, taken relative to the first sample to keep the cancellation small
+// - percentiles come from a fixed bucket histogram over a given range; a query walks the buckets, not the samples.
+//   Values outside the range land in the end buckets; the answer is clamped to the true min and max
+// The samples themselves are kept in a ring_buffer, for plotting.
+template <class T>
+struct window_stats
+{
+    ring_buffer<T> samples;
+    detail::window_queue minQueue;
+    detail::window_queue maxQueue;
+
+    double shift = 0.0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+
+    std::vector<uint32_t> histogram;
+    double histogramMin = 0.0;
+    double histogramScale = 0.0; // Buckets per unit
+};
+
+template <class T>
+void window_stats_init(window_stats<T>& stats, uint32_t capacity)
+{
+    ring_buffer_init(stats.samples, capacity);
+    for (auto* pQueue : { &stats.minQueue, &stats.maxQueue })
+    {
+        pQueue->items.assign(std::bit_ceil(std::max(capacity, 1u)), 0);
+        pQueue->front = pQueue->back = 0;
+    }
+    stats.shift = stats.sum = stats.sumSquares = 0.0;
+    stats.histogram.clear();
+}
+
+// With a percentile sketch of buckets over [minValue, maxValue]; resolution is (maxValue - minValue) / buckets
+template <class T>
+void window_stats_init(window_stats<T>& stats, uint32_t capacity, double minValue, double maxValue, uint32_t buckets = 256)
+{
+    window_stats_init(stats, capacity);
+    stats.histogram.assign(std::max(buckets, 1u), 0);
+    stats.histogramMin = minValue;
+    stats.histogramScale = maxValue > minValue ? double(stats.histogram.size()) / (maxValue - minValue) : 0.0;
+}
+
+namespace detail
+{
+
+template <class T>
+T window_stats_value(const window_stats<T>& stats, uint64_t sequence)
+{
+    return stats.samples.data[sequence & (stats.samples.data.size() - 1)];
+}
+
+template <class T>
+size_t window_stats_bucket(const window_stats<T>& stats, double value)
+{
+    auto bucket = (value - stats.histogramMin) * stats.histogramScale;
+    return size_t(std::clamp(bucket, 0.0, double(stats.histogram.size() - 1)));
+}
+
+} // namespace detail
+
+template <class T>
+size_t window_stats_size(const window_stats<T>& stats)
+{
+    return ring_buffer_size(stats.samples);
+}
+
+template <class T>
+bool window_stats_empty(const window_stats<T>& stats)
+{
+    return ring_buffer_empty(stats.samples);
+}
+
+template <class T>
+void window_stats_add(window_stats<T>& stats, T value)
+{
+    auto& samples = stats.samples;
+
+    // The oldest sample leaves first
+    if (ring_buffer_size(samples) == samples.capacity)
+    {
+        if (samples.capacity == 0)
+        {
+            return;
+        }
+
+        const auto leaving = uint64_t(samples.tail);
+        const auto oldest = double(detail::window_stats_value(stats, leaving));
+        stats.sum -= oldest - stats.shift;
+        stats.sumSquares -= (oldest - stats.shift) * (oldest - stats.shift);
+        if (!stats.histogram.empty())
+        {
+            stats.histogram[detail::window_stats_bucket(stats, oldest)]--;
+        }
+
+        for (auto* pQueue : { &stats.minQueue, &stats.maxQueue })
+        {
+            if (!pQueue->empty() && pQueue->first() == leaving)
+            {
+                pQueue->front++;
+            }
+        }
+    }
+    else if (ring_buffer_empty(samples))
+    {
+        stats.shift = double(value);
+        stats.sum = stats.sumSquares = 0.0;
+    }
+
+    // Anything the new value beats can never be the answer again
+    const auto sequence = uint64_t(samples.head);
+    ring_buffer_add(samples, value);
+    while (!stats.minQueue.empty() && !(detail::window_stats_value(stats, stats.minQueue.last()) < value))
+    {
+        stats.minQueue.back--;
+    }
+    stats.minQueue.push(sequence);
+    while (!stats.maxQueue.empty() && !(value < detail::window_stats_value(stats, stats.maxQueue.last())))
+    {
+        stats.maxQueue.back--;
+    }
+    stats.maxQueue.push(sequence);
+
+    const auto shifted = double(value) - stats.shift;
+    stats.sum += shifted;
+    stats.sumSquares += shifted * shifted;
+    if (!stats.histogram.empty())
+    {
+        stats.histogram[detail::window_stats_bucket(stats, double(value))]++;
+    }
+}
+
+template <class T>
+void window_stats_push_n(window_stats<T>& stats, std::type_identity_t<std::span<const T>> values)
+{
+    for (auto& value : values)
+    {
+        window_stats_add(stats, value);
+    }
+}
+
+template <class T>
+T window_stats_min(const window_stats<T>& stats)
+{
+    return stats.minQueue.empty() ? T{} : detail::window_stats_value(stats, stats.minQueue.first());
+}
+
+template <class T>
+T window_stats_max(const window_stats<T>& stats)
+{
+    return stats.maxQueue.empty() ? T{} : detail::window_stats_value(stats, stats.maxQueue.first());
+}
+
+template <class T>
+double window_stats_mean(const window_stats<T>& stats)
+{
+    const auto count = window_stats_size(stats);
+    return count ? stats.shift + stats.sum / double(count) : 0.0;
+}
+
+// Sample variance
+template <class T>
+double window_stats_variance(const window_stats<T>& stats)
+{
+    const auto count = double(window_stats_size(stats));
+    if (count < 2)
+    {
+        return 0.0;
+    }
+    return std::max(0.0, (stats.sumSquares - stats.sum * stats.sum / count) / (count - 1));
+}
+
+template <class T>
+double window_stats_stddev(const window_stats<T>& stats)
+{
+    return std::sqrt(window_stats_variance(stats));
+}
+
+// Approximate value below which fraction (0-1) of the window lies, to within a bucket. Needs the sketch
+template <class T>
+double window_stats_percentile(const window_stats<T>& stats, double fraction)
+{
+    const auto count = window_stats_size(stats);
+    if (count == 0 || stats.histogram.empty())
+    {
+        return 0.0;
+    }
+
+    const auto low = double(window_stats_min(stats));
+    const auto high = double(window_stats_max(stats));
+    if (stats.histogramScale == 0.0)
+    {
+        return std::clamp(stats.histogramMin, low, high);
+    }
+
+    const auto rank = std::clamp(fraction, 0.0, 1.0) * double(count);
+    double below = 0.0;
+    for (size_t bucket = 0; bucket < stats.histogram.size(); bucket++)
+    {
+        const auto inBucket = double(stats.histogram[bucket]);
+        if (inBucket > 0.0 && below + inBucket >= rank)
+        {
+            // Spread evenly across the bucket
+            const auto position = double(bucket) + (rank - below) / inBucket;
+            return std::clamp(stats.histogramMin + position / stats.histogramScale, low, high);
+        }
+        below += inBucket;
+    }
+    return high;
+}
+
+} // namespace Zest
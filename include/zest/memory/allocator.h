@@ -1,5 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef ZEST_PROFILE_MEMORY
+namespace Zest
+{
+namespace Profiler
+{
+void TrackAlloc(size_t size);
+void TrackFree(size_t size);
+} // namespace Profiler
+} // namespace Zest
+#endif
+
 namespace Zest
 {
 
@@ -18,10 +32,16 @@ public:
     stl_allocator(const stl_allocator<U>&) {}
     pointer allocate(size_type n)
     {
+#ifdef ZEST_PROFILE_MEMORY
+        Profiler::TrackAlloc(n * sizeof(T));
+#endif
         return (pointer)malloc(n * sizeof(T));
     }
     void deallocate(pointer p, size_type n)
     {
+#ifdef ZEST_PROFILE_MEMORY
+        Profiler::TrackFree(n * sizeof(T));
+#endif
         // Free knows how big the block is
         (void)&n;
         free(p);
@@ -1,7 +1,13 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <mutex>
+#include <thread>
+#include <zest/thread/thread_utils.h>
 #include <zest/time/profiler.h>
 
+// Double buffered memory behind a mutex; prefer Zest::triple_buffer, which never blocks or misses a publish.
 // Consumer always lock waits for memory
 // Producer never locks, but try-lock swaps after locking
 // From Consumer point of view, memory might be delayed/old
@@ -10,6 +16,8 @@ template <typename T, typename Mut>
 class PNL_CL_Memory
 {
 public:
+    using value_type = T;
+
     T& GetProducerMemory()
     {
         return memory[producerMemory];
@@ -40,24 +48,252 @@ public:
         m_swapMutex.unlock();
     };
 
+    void ReleaseConsumerMemory(T&)
+    {
+        ReleaseConsumerMemory();
+    }
+
 private:
     Mut m_swapMutex;
     uint32_t producerMemory = 0;
     T memory[2];
 };
 
-template <typename T, typename Mut>
+namespace Zest
+{
+
+// Single producer, single consumer. Neither side ever waits: the producer always publishes, and the consumer always
+// gets the latest complete publish. The three buffers rotate through an atomic index with a 'new data' bit, so the
+// producer starts each write on whichever buffer is free; it holds an older publish, not the last one written.
+template <typename T>
+class triple_buffer
+{
+public:
+    using value_type = T;
+
+    triple_buffer() = default;
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    // Producer thread only
+    T& GetProducerMemory()
+    {
+        return m_buffers[m_producer].data;
+    }
+
+    void ReleaseProducerMemory()
+    {
+        m_buffers[m_producer].version = ++m_published;
+        auto previous = m_middle.exchange(m_producer | NewData, std::memory_order_acq_rel);
+        m_producer = previous & IndexMask;
+    }
+
+    // Consumer thread only. Takes the newest publish, if there is one; otherwise re-reads the current one
+    T& GetConsumerMemory()
+    {
+        if (m_middle.load(std::memory_order_relaxed) & NewData)
+        {
+            auto previous = m_middle.exchange(m_consumer, std::memory_order_acq_rel);
+            m_consumer = previous & IndexMask;
+        }
+        return m_buffers[m_consumer].data;
+    }
+
+    void ReleaseConsumerMemory(T&)
+    {
+    }
+
+    // Something published since the consumer last looked
+    bool HasNewData() const
+    {
+        return m_middle.load(std::memory_order_relaxed) & NewData;
+    }
+
+    // Publish count of a buffer the caller holds; 0 before the first publish
+    uint64_t Version(const T& data) const
+    {
+        return Slot(data).version;
+    }
+
+private:
+    struct alignas(Zest::cache_line_size) Buffer
+    {
+        T data{};
+        uint64_t version = 0;
+    };
+
+    const Buffer& Slot(const T& data) const
+    {
+        for (auto& buffer : m_buffers)
+        {
+            if (&buffer.data == &data)
+            {
+                return buffer;
+            }
+        }
+        assert(!"Not one of our buffers");
+        return m_buffers[0];
+    }
+
+    static constexpr uint8_t IndexMask = 0x3;
+    static constexpr uint8_t NewData = 0x4;
+
+    std::array<Buffer, 3> m_buffers;
+    alignas(Zest::cache_line_size) std::atomic<uint8_t> m_middle = 1;
+    alignas(Zest::cache_line_size) uint8_t m_producer = 0;
+    uint64_t m_published = 0;
+    alignas(Zest::cache_line_size) uint8_t m_consumer = 2;
+};
+
+// Single producer, up to Readers consumers holding snapshots at once, from any threads. Each consumer pins the
+// latest publish with a reference count, so it stays intact until released. The producer never waits; it writes
+// into any buffer that is neither pinned nor the latest, and Readers + 2 buffers guarantee there is one.
+// Consumers retry only if a publish lands between reading the latest index and pinning it. Holders are counted;
+// beyond Readers, TryGetConsumerMemory fails and GetConsumerMemory waits for one to be released.
+template <typename T, size_t Readers = 4>
+class snapshot_buffer
+{
+public:
+    using value_type = T;
+    static constexpr size_t BufferCount = Readers + 2;
+
+    snapshot_buffer() = default;
+    snapshot_buffer(const snapshot_buffer&) = delete;
+    snapshot_buffer& operator=(const snapshot_buffer&) = delete;
+
+    // Producer thread only
+    T& GetProducerMemory()
+    {
+        return m_buffers[m_producer].data;
+    }
+
+    void ReleaseProducerMemory()
+    {
+        auto version = m_latest.load(std::memory_order_relaxed) >> VersionShift;
+        m_buffers[m_producer].version = version + 1;
+        m_latest.store(((version + 1) << VersionShift) | m_producer);
+
+        // Anything unpinned except what was just published. With at most Readers pinned there always is one; a
+        // second pass only covers an unpin this thread hasn't seen yet
+        for (;;)
+        {
+            for (size_t offset = 1; offset < BufferCount; offset++)
+            {
+                auto index = (m_producer + offset) % BufferCount;
+                if (m_buffers[index].pins.load() == 0)
+                {
+                    m_producer = index;
+                    return;
+                }
+            }
+            cpu_relax();
+        }
+    }
+
+    // Any thread; waits while Readers snapshots are already held
+    T& GetConsumerMemory()
+    {
+        T* pData;
+        while (!(pData = TryGetConsumerMemory()))
+        {
+            std::this_thread::yield();
+        }
+        return *pData;
+    }
+
+    // nullptr if Readers snapshots are already held
+    T* TryGetConsumerMemory()
+    {
+        // Reserve a reader before pinning, so no more than Readers buffers are ever pinned
+        if (m_readers.fetch_add(1) >= Readers)
+        {
+            m_readers.fetch_sub(1);
+            return nullptr;
+        }
+
+        for (;;)
+        {
+            auto latest = m_latest.load();
+            auto& buffer = m_buffers[latest & IndexMask];
+            buffer.pins.fetch_add(1);
+
+            // Still the latest, so the producer can't have started writing over it
+            if (m_latest.load() == latest)
+            {
+                return &buffer.data;
+            }
+            buffer.pins.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void ReleaseConsumerMemory(T& data)
+    {
+        const_cast<Buffer&>(Slot(data)).pins.fetch_sub(1, std::memory_order_release);
+        m_readers.fetch_sub(1);
+    }
+
+    // Publish count of the latest snapshot; consumers compare against Version() to skip unchanged data
+    uint64_t LatestVersion() const
+    {
+        return m_latest.load(std::memory_order_acquire) >> VersionShift;
+    }
+
+    uint64_t Version(const T& data) const
+    {
+        return Slot(data).version;
+    }
+
+private:
+    struct alignas(Zest::cache_line_size) Buffer
+    {
+        T data{};
+        uint64_t version = 0;
+        std::atomic<uint32_t> pins = 0;
+    };
+
+    const Buffer& Slot(const T& data) const
+    {
+        for (auto& buffer : m_buffers)
+        {
+            if (&buffer.data == &data)
+            {
+                return buffer;
+            }
+        }
+        assert(!"Not one of our buffers");
+        return m_buffers[0];
+    }
+
+    static constexpr uint64_t VersionShift = 8;
+    static constexpr uint64_t IndexMask = (1 << VersionShift) - 1;
+    static_assert(BufferCount <= IndexMask, "Too many readers");
+
+    std::array<Buffer, BufferCount> m_buffers;
+
+    // Version above, index of the latest buffer below; starts on the empty buffer 0, version 0
+    alignas(Zest::cache_line_size) std::atomic<uint64_t> m_latest = 0;
+    std::atomic<uint32_t> m_readers = 0;
+    alignas(Zest::cache_line_size) size_t m_producer = 1;
+};
+
+} // namespace Zest
+
+// The locks work with PNL_CL_Memory, Zest::triple_buffer or Zest::snapshot_buffer, e.g.
+// ConsumerMemLock lock(buffer); lock.Data()...
+template <typename Mem>
 class ConsumerMemLock
 {
 public:
-    ConsumerMemLock(PNL_CL_Memory<T, Mut>& lazyMem)
+    using T = typename Mem::value_type;
+
+    ConsumerMemLock(Mem& lazyMem)
         : memory(lazyMem.GetConsumerMemory())
         , mem(lazyMem)
     {
     }
     ~ConsumerMemLock()
     {
-        mem.ReleaseConsumerMemory();
+        mem.ReleaseConsumerMemory(memory);
     }
 
     T& Data() const
@@ -65,15 +301,23 @@ public:
         return memory;
     }
 
+    // Buffers which count publishes only
+    uint64_t Version() const
+    {
+        return mem.Version(memory);
+    }
+
     T& memory;
-    PNL_CL_Memory<T, Mut>& mem;
+    Mem& mem;
 };
 
-template <typename T, typename Mut>
+template <typename Mem>
 class ProducerMemLock
 {
 public:
-    ProducerMemLock(PNL_CL_Memory<T, Mut>& lazyMem)
+    using T = typename Mem::value_type;
+
+    ProducerMemLock(Mem& lazyMem)
         : memory(lazyMem.GetProducerMemory())
         , mem(lazyMem)
     {
@@ -89,6 +333,6 @@ public:
     }
 
     T& memory;
-    PNL_CL_Memory<T, Mut>& mem;
+    Mem& mem;
 };
 
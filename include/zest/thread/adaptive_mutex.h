@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// Contention counters for the adaptive mutexes; relaxed, so only roughly in step with each other
+struct mutex_stats
+{
+    uint64_t acquisitions = 0; // Successful locks, shared or exclusive
+    uint64_t contended = 0;    // Locks which didn't get in on the first try
+    uint64_t parks = 0;        // Times a thread went to sleep in the kernel
+    uint64_t spins = 0;        // Spin iterations before getting in or parking
+
+    double ContendedFraction() const
+    {
+        return acquisitions ? double(contended) / double(acquisitions) : 0.0;
+    }
+};
+
+namespace detail
+{
+
+// How long to spin before parking is learnt per mutex, like glibc's adaptive mutexes:
+// spin up to twice the recent successful spin count, so locks held briefly are spun on and long ones park quickly
+constexpr uint32_t AdaptiveMaxSpins = 1000;
+constexpr uint32_t AdaptiveMinSpins = 10;
+
+// Spinning only helps if the holder can run at the same time
+inline bool adaptive_can_spin()
+{
+    static const bool canSpin = std::thread::hardware_concurrency() > 1;
+    return canSpin;
+}
+
+struct mutex_counters
+{
+    std::atomic<uint64_t> acquisitions = 0;
+    std::atomic<uint64_t> contended = 0;
+    std::atomic<uint64_t> parks = 0;
+    std::atomic<uint64_t> spins = 0;
+
+    mutex_stats load() const
+    {
+        mutex_stats stats;
+        stats.acquisitions = acquisitions.load(std::memory_order_relaxed);
+        stats.contended = contended.load(std::memory_order_relaxed);
+        stats.parks = parks.load(std::memory_order_relaxed);
+        stats.spins = spins.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void reset()
+    {
+        acquisitions.store(0, std::memory_order_relaxed);
+        contended.store(0, std::memory_order_relaxed);
+        parks.store(0, std::memory_order_relaxed);
+        spins.store(0, std::memory_order_relaxed);
+    }
+
+    void add(std::atomic<uint64_t>& counter, uint64_t amount = 1)
+    {
+        counter.fetch_add(amount, std::memory_order_relaxed);
+    }
+};
+
+} // namespace detail
+
+// Spins briefly then sleeps on the lock word (a futex on Linux, WaitOnAddress on Windows) instead of yielding in a loop.
+// Use in place of spin_mutex where threads may be descheduled while holding or waiting on the lock
+class adaptive_mutex
+{
+public:
+    adaptive_mutex() = default;
+    adaptive_mutex(const adaptive_mutex&) = delete;
+    adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+    void lock() noexcept
+    {
+        uint32_t expected = Unlocked;
+        if (!m_state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            lock_contended();
+        }
+        m_counters.add(m_counters.acquisitions);
+    }
+
+    bool try_lock() noexcept
+    {
+        uint32_t expected = Unlocked;
+        if (m_state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            m_counters.add(m_counters.acquisitions);
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() noexcept
+    {
+        // Only pay for the wake when somebody said they were sleeping
+        if (m_state.exchange(Unlocked, std::memory_order_release) == LockedWaiters)
+        {
+            m_state.notify_one();
+        }
+    }
+
+    mutex_stats stats() const
+    {
+        return m_counters.load();
+    }
+
+    void reset_stats()
+    {
+        m_counters.reset();
+    }
+
+private:
+    void lock_contended() noexcept
+    {
+        m_counters.add(m_counters.contended);
+
+        if (detail::adaptive_can_spin())
+        {
+            const auto estimate = m_spinEstimate.load(std::memory_order_relaxed);
+            const auto maxSpins = std::min(estimate * 2 + detail::AdaptiveMinSpins, detail::AdaptiveMaxSpins);
+            for (uint32_t spin = 0; spin < maxSpins; spin++)
+            {
+                // Read before writing, so spinners don't steal the cache line from the holder
+                if (m_state.load(std::memory_order_relaxed) == Unlocked)
+                {
+                    uint32_t expected = Unlocked;
+                    if (m_state.compare_exchange_weak(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                        update_estimate(estimate, spin);
+                        m_counters.add(m_counters.spins, spin);
+                        return;
+                    }
+                }
+                cpu_relax();
+            }
+            update_estimate(estimate, maxSpins);
+            m_counters.add(m_counters.spins, maxSpins);
+        }
+
+        // Mark the lock as having sleepers; whoever takes it this way keeps the mark, since others may still be asleep
+        while (m_state.exchange(LockedWaiters, std::memory_order_acquire) != Unlocked)
+        {
+            m_counters.add(m_counters.parks);
+            m_state.wait(LockedWaiters, std::memory_order_relaxed);
+        }
+    }
+
+    // Moves an eighth of the way towards the latest spin count
+    void update_estimate(uint32_t estimate, uint32_t spins) noexcept
+    {
+        m_spinEstimate.store(uint32_t(int32_t(estimate) + (int32_t(spins) - int32_t(estimate)) / 8), std::memory_order_relaxed);
+    }
+
+    static constexpr uint32_t Unlocked = 0;
+    static constexpr uint32_t Locked = 1;
+    static constexpr uint32_t LockedWaiters = 2;
+
+    std::atomic<uint32_t> m_state = Unlocked;
+    std::atomic<uint32_t> m_spinEstimate = 0;
+    detail::mutex_counters m_counters;
+};
+
+// Reader-writer version. Writers are preferred: once one is waiting, new readers queue behind it
+class adaptive_shared_mutex
+{
+public:
+    adaptive_shared_mutex() = default;
+    adaptive_shared_mutex(const adaptive_shared_mutex&) = delete;
+    adaptive_shared_mutex& operator=(const adaptive_shared_mutex&) = delete;
+
+    void lock() noexcept
+    {
+        uint32_t expected = 0;
+        if (!m_state.compare_exchange_strong(expected, Writer, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            m_counters.add(m_counters.contended);
+            acquire([](uint32_t state) { return (state & (Writer | ReaderMask)) == 0; },
+                [](uint32_t state) { return (state | Writer) & ~WriterPending; },
+                WriterPending);
+        }
+        m_counters.add(m_counters.acquisitions);
+    }
+
+    bool try_lock() noexcept
+    {
+        auto state = m_state.load(std::memory_order_relaxed);
+        if ((state & (Writer | ReaderMask)) == 0 && m_state.compare_exchange_strong(state, (state | Writer) & ~WriterPending, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            m_counters.add(m_counters.acquisitions);
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() noexcept
+    {
+        if (m_state.fetch_and(~(Writer | Parked), std::memory_order_release) & Parked)
+        {
+            m_state.notify_all();
+        }
+    }
+
+    void lock_shared() noexcept
+    {
+        if (!try_lock_shared_once())
+        {
+            m_counters.add(m_counters.contended);
+            acquire([](uint32_t state) { return (state & (Writer | WriterPending)) == 0; },
+                [](uint32_t state) { return state + 1; },
+                0);
+        }
+        m_counters.add(m_counters.acquisitions);
+    }
+
+    bool try_lock_shared() noexcept
+    {
+        if (try_lock_shared_once())
+        {
+            m_counters.add(m_counters.acquisitions);
+            return true;
+        }
+        return false;
+    }
+
+    void unlock_shared() noexcept
+    {
+        // The last reader out wakes anyone waiting on it. Leaving and clearing the mark must be one step,
+        // or a writer could get in between and lose the mark for the readers parked behind it
+        auto state = m_state.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            const bool wake = (state & ReaderMask) == 1 && (state & Parked);
+            auto next = wake ? (state - 1) & ~Parked : state - 1;
+            if (m_state.compare_exchange_weak(state, next, std::memory_order_release, std::memory_order_relaxed))
+            {
+                if (wake)
+                {
+                    m_state.notify_all();
+                }
+                return;
+            }
+        }
+    }
+
+    mutex_stats stats() const
+    {
+        return m_counters.load();
+    }
+
+    void reset_stats()
+    {
+        m_counters.reset();
+    }
+
+private:
+    bool try_lock_shared_once() noexcept
+    {
+        auto state = m_state.load(std::memory_order_relaxed);
+        while ((state & (Writer | WriterPending)) == 0)
+        {
+            if (m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Spin, then park with the Parked bit (and any extra bits, e.g. WriterPending) set until canEnter holds
+    template <class CanEnter, class Enter>
+    void acquire(CanEnter canEnter, Enter enter, uint32_t waitBits) noexcept
+    {
+        uint32_t spin = 0;
+        const auto maxSpins = detail::adaptive_can_spin() ? detail::AdaptiveMaxSpins / 4 : 0;
+        for (;;)
+        {
+            auto state = m_state.load(std::memory_order_relaxed);
+            if (canEnter(state))
+            {
+                if (m_state.compare_exchange_weak(state, enter(state), std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    m_counters.add(m_counters.spins, spin);
+                    return;
+                }
+                continue;
+            }
+
+            if (spin < maxSpins)
+            {
+                spin++;
+                cpu_relax();
+                continue;
+            }
+
+            auto parked = state | Parked | waitBits;
+            if (parked != state && !m_state.compare_exchange_weak(state, parked, std::memory_order_relaxed))
+            {
+                continue;
+            }
+            m_counters.add(m_counters.parks);
+            m_state.wait(parked, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr uint32_t Writer = 1u << 31;
+    static constexpr uint32_t WriterPending = 1u << 30;
+    static constexpr uint32_t Parked = 1u << 29;
+    static constexpr uint32_t ReaderMask = Parked - 1;
+
+    std::atomic<uint32_t> m_state = 0;
+    detail::mutex_counters m_counters;
+};
+
+} // namespace Zest
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include <zest/algorithm/ring_buffer.h>
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// What the producer does when the ring is full; fixed per ring type
+enum class broadcast_overflow
+{
+    Block,     // Wait for the slowest consumer; nobody misses anything
+    Overwrite  // Carry on; consumers that fall behind skip ahead and count what they lost. Small items only
+};
+
+// How either side waits: spinning is lowest latency and burns a core, parking sleeps in the kernel
+enum class wait_strategy
+{
+    BusySpin,
+    Yield,
+    Park
+};
+
+namespace detail
+{
+
+// Items the producer can overwrite while they are read must be copied as single lock free atomics
+template <class T>
+constexpr bool broadcast_overwritable()
+{
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        return std::atomic_ref<T>::is_always_lock_free && std::atomic_ref<T>::required_alignment <= alignof(T);
+    }
+    return false;
+}
+
+} // namespace detail
+
+// One producer, a fixed set of consumers, one copy of the data (Disruptor style). Each consumer has its own cursor,
+// so every consumer sees every item (within the overflow policy) without the producer copying per consumer.
+// Items are claimed and published in batches as ring_spans, and with Block read in place by consumers.
+// With Overwrite the slots are only touched atomically: claims are staged and copied in by publish(), and poll/wait
+// copy out into the consumer's own buffer, dropping (as lost) any items written over during the copy. So Overwrite
+// is for word sized items (samples, counters, small PODs), and the spans a consumer gets last until its next poll.
+// Other items don't compile with Overwrite
+template <class T, broadcast_overflow Overflow = broadcast_overflow::Block>
+class broadcast_ring
+{
+public:
+    static constexpr bool overwritable = detail::broadcast_overwritable<T>();
+    static constexpr broadcast_overflow overflow = Overflow;
+    static_assert(Overflow == broadcast_overflow::Block || overwritable, "Overwrite needs trivially copyable, lock free atomic sized items");
+
+    broadcast_ring(size_t capacity, size_t consumers, wait_strategy wait = wait_strategy::Yield)
+        : m_capacity(std::bit_ceil(std::max(capacity, size_t(1))))
+        , m_mask(m_capacity - 1)
+        , m_consumerCount(consumers)
+        , m_wait(wait)
+        , m_data(std::make_unique<T[]>(m_capacity))
+        , m_cursors(std::make_unique<Cursor[]>(consumers))
+    {
+        if constexpr (Overflow == broadcast_overflow::Overwrite)
+        {
+            m_staging = std::make_unique<T[]>(m_capacity);
+            m_copies = std::make_unique<T[]>(m_capacity * consumers);
+        }
+    }
+
+    broadcast_ring(const broadcast_ring&) = delete;
+    broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    size_t consumer_count() const
+    {
+        return m_consumerCount;
+    }
+
+    uint64_t published() const
+    {
+        return m_published.load(std::memory_order_acquire);
+    }
+
+    // Producer. Space for count more items (at most capacity), waiting on the slowest consumer if the policy says so.
+    // Claims add up until publish()
+    ring_span<T> claim(size_t count)
+    {
+        count = std::min(count, m_capacity);
+        const auto end = m_head + count;
+        if constexpr (Overflow == broadcast_overflow::Block)
+        {
+            wait_for_space(end);
+        }
+
+        auto span = segments(Overflow == broadcast_overflow::Block ? m_data.get() : m_staging.get(), m_head, count);
+        m_head = end;
+        return span;
+    }
+
+    // Make everything claimed so far visible to the consumers
+    void publish()
+    {
+        if constexpr (Overflow == broadcast_overflow::Overwrite)
+        {
+            copy_in();
+        }
+
+        m_published.store(m_head, std::memory_order_seq_cst);
+        if (m_wait == wait_strategy::Park && m_parkedConsumers.load() > 0)
+        {
+            wake_consumers();
+        }
+    }
+
+    void push(const T& item)
+    {
+        claim(1).first[0] = item;
+        publish();
+    }
+
+    // No more data; waiting consumers return once they have drained the ring
+    void close()
+    {
+        m_closed.store(true);
+        wake_consumers();
+    }
+
+    // Consumer. What consumer can read now, without waiting
+    ring_span<const T> poll(size_t consumer, size_t maxCount = SIZE_MAX)
+    {
+        auto& cursor = m_cursors[consumer];
+        auto sequence = cursor.sequence.load(std::memory_order_relaxed);
+        const auto published = m_published.load(std::memory_order_acquire);
+
+        // Lapped; skip to the oldest item still there
+        if (published - sequence > m_capacity)
+        {
+            skip(cursor, published - m_capacity - sequence);
+            sequence = published - m_capacity;
+        }
+
+        const auto count = size_t(std::min<uint64_t>(maxCount, published - sequence));
+        if constexpr (Overflow == broadcast_overflow::Overwrite)
+        {
+            return copy_out(consumer, sequence, count);
+        }
+        else
+        {
+            auto run = segments(m_data.get(), sequence, count);
+            return { run.first, run.second };
+        }
+    }
+
+    // As poll, but waits for at least one item. Empty only once closed and drained
+    ring_span<const T> wait(size_t consumer, size_t maxCount = SIZE_MAX)
+    {
+        auto& cursor = m_cursors[consumer];
+        for (uint32_t round = 0;; round++)
+        {
+            // Closed before published, so everything published before the close is seen
+            const bool closed = m_closed.load();
+            const auto sequence = cursor.sequence.load(std::memory_order_relaxed);
+            if (m_published.load(std::memory_order_acquire) != sequence)
+            {
+                // With Overwrite, all of it may have been written over as it was copied; then look again
+                auto items = poll(consumer, maxCount);
+                if (!items.empty())
+                {
+                    return items;
+                }
+                continue;
+            }
+
+            if (closed)
+            {
+                return {};
+            }
+
+            if (!pause(round))
+            {
+                // Announce, then check again; a publish either sees us or we see it
+                auto signal = m_consumerSignal.load();
+                m_parkedConsumers.fetch_add(1);
+                if (m_published.load() == sequence && !m_closed.load())
+                {
+                    m_consumerSignal.wait(signal);
+                }
+                m_parkedConsumers.fetch_sub(1);
+            }
+        }
+    }
+
+    // Done with count items from the last poll/wait
+    void release(size_t consumer, size_t count)
+    {
+        auto& cursor = m_cursors[consumer];
+        const auto sequence = cursor.sequence.load(std::memory_order_relaxed);
+        cursor.sequence.store(sequence + count, std::memory_order_seq_cst);
+        if (m_producerParked.load())
+        {
+            cursor.sequence.notify_all();
+        }
+    }
+
+    // Items a consumer skipped because the producer lapped it, or wrote over them while they were copied
+    uint64_t lost(size_t consumer) const
+    {
+        return m_cursors[consumer].lost.load(std::memory_order_relaxed);
+    }
+
+    // Stop a consumer holding the producer back; it mustn't read again
+    void detach(size_t consumer)
+    {
+        m_cursors[consumer].sequence.store(Detached);
+        if (m_producerParked.load())
+        {
+            m_cursors[consumer].sequence.notify_all();
+        }
+    }
+
+private:
+    struct alignas(cache_line_size) Cursor
+    {
+        std::atomic<uint64_t> sequence = 0;
+        std::atomic<uint64_t> lost = 0;
+    };
+
+    static constexpr uint64_t Detached = UINT64_MAX;
+
+    // Runs of count items from sequence start, in a ring sized buffer
+    ring_span<T> segments(T* pBuffer, uint64_t start, size_t count) const
+    {
+        const auto offset = size_t(start & m_mask);
+        const auto first = std::min(count, m_capacity - offset);
+        return { std::span<T>(pBuffer + offset, first), std::span<T>(pBuffer, count - first) };
+    }
+
+    void skip(Cursor& cursor, uint64_t count)
+    {
+        cursor.lost.store(cursor.lost.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        cursor.sequence.store(cursor.sequence.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Overwrite: the staged claims into the ring, as a seqlock writer would; readers learn which slots are being
+    // replaced before any of them change
+    void copy_in()
+        requires(Overflow == broadcast_overflow::Overwrite)
+    {
+        const auto published = m_published.load(std::memory_order_relaxed);
+        m_claimed.store(m_head, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (auto sequence = published; sequence != m_head; sequence++)
+        {
+            const auto index = size_t(sequence & m_mask);
+            std::atomic_ref<T>(m_data[index]).store(m_staging[index], std::memory_order_relaxed);
+        }
+    }
+
+    // Overwrite: copy count items from sequence into the consumer's buffer, then drop any the producer may have
+    // replaced while they were copied
+    ring_span<const T> copy_out(size_t consumer, uint64_t sequence, size_t count)
+        requires(Overflow == broadcast_overflow::Overwrite)
+    {
+        auto* pCopies = m_copies.get() + consumer * m_capacity;
+        for (size_t item = 0; item < count; item++)
+        {
+            const auto index = size_t((sequence + item) & m_mask);
+            pCopies[index] = std::atomic_ref<T>(m_data[index]).load(std::memory_order_relaxed);
+        }
+
+        // Keep the copy above the check; slots below claimed - capacity have been, or are being, written over
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto overwritten = m_claimed.load(std::memory_order_relaxed) - m_capacity;
+        if (int64_t(overwritten - sequence) > 0)
+        {
+            const auto torn = size_t(std::min<uint64_t>(overwritten - sequence, count));
+            skip(m_cursors[consumer], torn);
+            sequence += torn;
+            count -= torn;
+        }
+
+        auto run = segments(pCopies, sequence, count);
+        return { run.first, run.second };
+    }
+
+    void wake_consumers()
+    {
+        m_consumerSignal.fetch_add(1);
+        m_consumerSignal.notify_all();
+    }
+
+    // Spins or yields for a while; false when it is time to park
+    bool pause(uint32_t round) const
+    {
+        switch (m_wait)
+        {
+        case wait_strategy::BusySpin:
+            cpu_relax();
+            return true;
+        case wait_strategy::Yield:
+            if (round < 64)
+            {
+                cpu_relax();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+            return true;
+        default:
+            if (round < 64)
+            {
+                cpu_relax();
+                return true;
+            }
+            return false;
+        }
+    }
+
+    // The slowest attached consumer, remembered until it no longer covers what the producer needs
+    void wait_for_space(uint64_t end)
+    {
+        if (end - m_gate <= m_capacity || m_consumerCount == 0)
+        {
+            return;
+        }
+
+        for (uint32_t round = 0;; round++)
+        {
+            uint64_t slowest = Detached;
+            size_t slowestIndex = 0;
+            for (size_t index = 0; index < m_consumerCount; index++)
+            {
+                auto sequence = m_cursors[index].sequence.load(std::memory_order_acquire);
+                if (sequence < slowest)
+                {
+                    slowest = sequence;
+                    slowestIndex = index;
+                }
+            }
+
+            // Everyone detached
+            if (slowest == Detached)
+            {
+                m_gate = end;
+                return;
+            }
+
+            m_gate = slowest;
+            if (end - slowest <= m_capacity)
+            {
+                return;
+            }
+
+            if (!pause(round))
+            {
+                auto& cursor = m_cursors[slowestIndex].sequence;
+                m_producerParked.store(true);
+                if (cursor.load() == slowest)
+                {
+                    cursor.wait(slowest);
+                }
+                m_producerParked.store(false);
+            }
+        }
+    }
+
+    const size_t m_capacity;
+    const uint64_t m_mask;
+    const size_t m_consumerCount;
+    const wait_strategy m_wait;
+    std::unique_ptr<T[]> m_data;
+    std::unique_ptr<Cursor[]> m_cursors;
+    std::unique_ptr<T[]> m_staging; // Overwrite: claims, until publish copies them in
+    std::unique_ptr<T[]> m_copies;  // Overwrite: a ring sized buffer per consumer, for what poll copied out
+
+    // Producer only
+    uint64_t m_head = 0;
+    uint64_t m_gate = 0;
+
+    alignas(cache_line_size) std::atomic<uint64_t> m_published = 0;
+    std::atomic<bool> m_closed = false;
+    std::atomic<uint32_t> m_parkedConsumers = 0;
+    std::atomic<uint32_t> m_consumerSignal = 0;
+
+    alignas(cache_line_size) std::atomic<uint64_t> m_claimed = 0;
+    std::atomic<bool> m_producerParked = false;
+};
+
+} // namespace Zest
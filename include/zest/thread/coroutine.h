@@ -0,0 +1,630 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <zest/thread/thread_utils.h>
+#include <zest/thread/threadpool.h>
+#include <zest/time/time_provider.h>
+
+namespace Zest
+{
+
+// C++20 coroutines on the Zest thread pool.
+//
+// task<T> is lazy; it starts when awaited, and resumes its awaiter when it finishes (symmetric transfer, so long
+// chains don't grow the stack). co_await schedule_on(pool) moves the rest of a coroutine onto a pool worker.
+// when_all/when_any start a set of tasks and wait for all/the first; tasks that should run in parallel
+// begin with co_await schedule_on(pool). sync_wait() runs a task from ordinary code and blocks for the result.
+// Coroutine frames come from a recycling allocator, so steady state task creation doesn't hit the heap.
+
+template <typename T = void>
+class task;
+
+namespace detail
+{
+
+void* coroutine_frame_alloc(size_t size);
+void coroutine_frame_free(void* p, size_t size) noexcept;
+
+struct frame_allocated
+{
+    static void* operator new(size_t size)
+    {
+        return coroutine_frame_alloc(size);
+    }
+
+    static void operator delete(void* p, size_t size) noexcept
+    {
+        coroutine_frame_free(p, size);
+    }
+};
+
+struct task_promise_base : frame_allocated
+{
+    struct final_awaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    final_awaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        error = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template <typename T>
+struct task_promise : task_promise_base
+{
+    task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& value)
+    {
+        result.emplace(std::forward<U>(value));
+    }
+
+    T take_result()
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template <>
+struct task_promise<void> : task_promise_base
+{
+    task<void> get_return_object();
+
+    void return_void()
+    {
+    }
+
+    void take_result()
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+// Starts immediately and frees itself when done; the glue for when_all, when_any and sync_wait
+struct detached
+{
+    struct promise_type : frame_allocated
+    {
+        detached get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] task
+{
+public:
+    using promise_type = detail::task_promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task() = default;
+
+    explicit task(handle_type handle)
+        : m_handle(handle)
+    {
+    }
+
+    task(task&& rhs) noexcept
+        : m_handle(std::exchange(rhs.m_handle, nullptr))
+    {
+    }
+
+    task& operator=(task&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            destroy();
+            m_handle = std::exchange(rhs.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task()
+    {
+        destroy();
+    }
+
+    bool done() const
+    {
+        return !m_handle || m_handle.done();
+    }
+
+    auto operator co_await() noexcept
+    {
+        struct awaiter
+        {
+            handle_type handle;
+
+            bool await_ready() noexcept
+            {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+            {
+                handle.promise().continuation = continuation;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().take_result();
+            }
+        };
+        return awaiter{ m_handle };
+    }
+
+private:
+    void destroy()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+private:
+    handle_type m_handle = nullptr;
+};
+
+namespace detail
+{
+
+template <typename T>
+task<T> task_promise<T>::get_return_object()
+{
+    return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object()
+{
+    return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+// Counts down the children plus one for the awaiter itself, so a child that finishes
+// before the awaiter has suspended can't resume it early
+struct join_state
+{
+    std::atomic<size_t> remaining = 0;
+    std::coroutine_handle<> continuation;
+};
+
+template <typename Start>
+struct join_awaiter
+{
+    join_state& state;
+    size_t count;
+    Start start;
+
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> continuation)
+    {
+        state.continuation = continuation;
+        state.remaining.store(count + 1, std::memory_order_relaxed);
+        start();
+        return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() noexcept
+    {
+    }
+};
+
+inline void join_release(join_state& state)
+{
+    if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        state.continuation.resume();
+    }
+}
+
+template <typename T>
+detached when_all_child(task<T>& child, join_state& state, std::optional<T>& result, std::exception_ptr& error)
+{
+    try
+    {
+        result.emplace(co_await child);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    join_release(state);
+}
+
+inline detached when_all_child(task<void>& child, join_state& state, std::exception_ptr& error)
+{
+    try
+    {
+        co_await child;
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    join_release(state);
+}
+
+// Shared with the children, which may still be running after the winner has resumed the awaiter
+template <typename T>
+struct when_any_state
+{
+    join_state join;
+    std::atomic<bool> finished = false;
+    size_t index = 0;
+    std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> result{};
+    std::exception_ptr error;
+    std::vector<task<T>> tasks;
+};
+
+template <typename T>
+detached when_any_child(std::shared_ptr<when_any_state<T>> pState, size_t index)
+{
+    std::exception_ptr error;
+    std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> result{};
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            co_await pState->tasks[index];
+        }
+        else
+        {
+            result.emplace(co_await pState->tasks[index]);
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (!pState->finished.exchange(true, std::memory_order_acq_rel))
+    {
+        pState->index = index;
+        pState->result = std::move(result);
+        pState->error = error;
+        join_release(pState->join);
+    }
+}
+
+} // namespace detail
+
+// Resume the awaiting coroutine on a pool worker
+inline auto schedule_on(TPool& pool)
+{
+    struct awaiter
+    {
+        TPool& pool;
+
+        bool await_ready() noexcept
+        {
+            // A pool without workers runs jobs inline, so just carry on
+            return pool.thread_count() == 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            pool.submit([handle]() {
+                handle.resume();
+            });
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+    return awaiter{ pool };
+}
+
+// Waits for every task; results are in the same order as the tasks. Rethrows the first failure after all have finished
+template <typename T>
+task<std::vector<T>> when_all(std::vector<task<T>> tasks)
+{
+    detail::join_state state;
+    std::vector<std::optional<T>> results(tasks.size());
+    std::vector<std::exception_ptr> errors(tasks.size());
+
+    co_await detail::join_awaiter{ state, tasks.size(), [&]() {
+        for (size_t index = 0; index < tasks.size(); index++)
+        {
+            detail::when_all_child(tasks[index], state, results[index], errors[index]);
+        }
+    } };
+
+    std::vector<T> values;
+    values.reserve(results.size());
+    for (size_t index = 0; index < results.size(); index++)
+    {
+        if (errors[index])
+        {
+            std::rethrow_exception(errors[index]);
+        }
+        values.push_back(std::move(*results[index]));
+    }
+    co_return values;
+}
+
+inline task<void> when_all(std::vector<task<void>> tasks)
+{
+    detail::join_state state;
+    std::vector<std::exception_ptr> errors(tasks.size());
+
+    co_await detail::join_awaiter{ state, tasks.size(), [&]() {
+        for (size_t index = 0; index < tasks.size(); index++)
+        {
+            detail::when_all_child(tasks[index], state, errors[index]);
+        }
+    } };
+
+    for (auto& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+template <typename T>
+struct when_any_result
+{
+    size_t index;
+    T value;
+};
+
+// Resumes when the first task finishes; the others run to completion in the background and their results are dropped
+template <typename T>
+task<when_any_result<T>> when_any(std::vector<task<T>> tasks)
+{
+    assert(!tasks.empty());
+    auto pState = std::make_shared<detail::when_any_state<T>>();
+    pState->tasks = std::move(tasks);
+
+    co_await detail::join_awaiter{ pState->join, 1, [&]() {
+        for (size_t index = 0; index < pState->tasks.size(); index++)
+        {
+            detail::when_any_child(pState, index);
+        }
+    } };
+
+    if (pState->error)
+    {
+        std::rethrow_exception(pState->error);
+    }
+    co_return when_any_result<T>{ pState->index, std::move(*pState->result) };
+}
+
+// Returns the index of the first task to finish
+inline task<size_t> when_any(std::vector<task<void>> tasks)
+{
+    assert(!tasks.empty());
+    auto pState = std::make_shared<detail::when_any_state<void>>();
+    pState->tasks = std::move(tasks);
+
+    co_await detail::join_awaiter{ pState->join, 1, [&]() {
+        for (size_t index = 0; index < pState->tasks.size(); index++)
+        {
+            detail::when_any_child(pState, index);
+        }
+    } };
+
+    if (pState->error)
+    {
+        std::rethrow_exception(pState->error);
+    }
+    co_return pState->index;
+}
+
+// Run a task from ordinary code, blocking until it is done. Don't call this from a pool worker; it can't help
+template <typename T>
+T sync_wait(task<T> t)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+    std::exception_ptr error;
+    std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> result{};
+
+    auto runner = [&]() -> detail::detached {
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                co_await t;
+            }
+            else
+            {
+                result.emplace(co_await t);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // Notify under the lock, so the waiter can't return and destroy it first
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        condition.notify_all();
+    };
+    runner();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return done; });
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    if constexpr (!std::is_void_v<T>)
+    {
+        return std::move(*result);
+    }
+}
+
+// Coroutine timers. sleep_until/sleep_for are driven by their own deadlines, on a thread that waits for the earliest
+// one; wait_for_beat is checked on each TimeProvider tick. Nothing is resumed on the tick thread, which holds the
+// provider's lock: ticks only hand ready waiters over to the timer thread.
+// Waiters resume on the pool if one is given, otherwise on the timer thread. Any still waiting when the queue is
+// destroyed are never resumed
+class timer_queue : public ITimeConsumer
+{
+public:
+    explicit timer_queue(TPool* pPool = nullptr);
+    virtual ~timer_queue();
+
+    timer_queue(const timer_queue&) = delete;
+    timer_queue& operator=(const timer_queue&) = delete;
+
+    void Tick() override;
+
+    auto sleep_until(TimePoint time)
+    {
+        return awaiter{ *this, time, 0.0 };
+    }
+
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> duration)
+    {
+        return sleep_until(TimeProvider::Instance().Now() + std::chrono::duration_cast<TimePoint::duration>(duration));
+    }
+
+    // Resume once the provider's beat count reaches beat
+    auto wait_for_beat(double beat)
+    {
+        return awaiter{ *this, TimePoint::min(), beat };
+    }
+
+    size_t pending() const;
+
+private:
+    struct waiter
+    {
+        TimePoint time;
+        double beat;
+        std::coroutine_handle<> handle;
+    };
+
+    struct awaiter
+    {
+        timer_queue& queue;
+        TimePoint time;
+        double beat;
+
+        bool await_ready() const
+        {
+            return queue.is_ready(time, beat);
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            queue.add(waiter{ time, beat, handle });
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    bool is_ready(TimePoint time, double beat) const;
+    void add(const waiter& w);
+    void resume(std::coroutine_handle<> handle);
+    void run();
+
+private:
+    TPool* m_pPool = nullptr;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<waiter> m_timers; // Heap, earliest time first
+    std::vector<waiter> m_beats;
+    std::vector<std::coroutine_handle<>> m_ready; // Beat waiters a tick found ready, for the timer thread
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace Zest
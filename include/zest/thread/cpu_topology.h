@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Zest
+{
+
+// One online logical CPU. Domain ids are dense indices, shared by every CPU in the same core/cache/node
+struct CpuInfo
+{
+    uint32_t id = 0;
+    uint32_t core = 0;     // Physical core; SMT siblings share it
+    uint32_t package = 0;
+    uint32_t l2Domain = 0;
+    uint32_t l3Domain = 0;
+    uint32_t numaNode = 0;
+};
+
+struct CpuTopology
+{
+    std::vector<CpuInfo> cpus;
+    uint32_t physicalCores = 0;
+    uint32_t l2Domains = 0;
+    uint32_t l3Domains = 0;
+    uint32_t numaNodes = 0;
+
+    // Logical CPUs in a domain
+    std::vector<uint32_t> CoreCpus(uint32_t core) const;
+    std::vector<uint32_t> L3Cpus(uint32_t domain) const;
+    std::vector<uint32_t> NumaCpus(uint32_t node) const;
+};
+
+enum class CpuPinPolicy
+{
+    None,          // Leave placement to the OS
+    PhysicalCores, // One worker per physical core, free to move between its SMT siblings
+    LogicalCpus,   // One worker per logical CPU
+    CacheDomain,   // All workers confined to the CPUs sharing one L3
+    NumaNode       // All workers confined to one NUMA node
+};
+
+// Read from /sys on Linux; elsewhere every hardware thread is reported as its own core.
+// The result is read once and cached
+const CpuTopology& cpu_topology();
+
+// Read a topology from a sysfs style tree, e.g. "/sys/devices/system"
+CpuTopology cpu_topology_read(const std::string& sysRoot);
+
+// Parse a kernel cpu list, e.g. "0-3,8,10-11"
+std::vector<uint32_t> cpu_list_parse(const std::string& list);
+
+// The CPUs each of workerCount workers should be confined to under a policy; empty sets mean unpinned.
+// The last reservedCores physical cores are left out, to keep them free for the audio thread and friends.
+// domain selects the L3 domain or NUMA node for the confining policies
+std::vector<std::vector<uint32_t>> cpu_pin_plan(const CpuTopology& topology, CpuPinPolicy policy, size_t workerCount, uint32_t reservedCores = 0, uint32_t domain = 0);
+
+// CPUs not handed out by cpu_pin_plan because of reservedCores
+std::vector<uint32_t> cpu_reserved_cpus(const CpuTopology& topology, uint32_t reservedCores);
+
+// Returns false where affinity isn't supported or the call fails
+bool thread_pin_current(const std::vector<uint32_t>& cpus);
+
+// Visible in debuggers and tools like top; Linux truncates to 15 characters
+void thread_set_current_name(const char* pszName);
+
+} // namespace Zest
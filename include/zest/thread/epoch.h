@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Zest
+{
+
+// Epoch based reclamation: when is it safe to free the old version of something a lock free structure has replaced?
+// Readers pin() for as long as they hold pointers into shared structures. A writer that unlinks a node retire()s it
+// instead of deleting it, and it is deleted, later and in batches, once every thread that was pinned when it was
+// unlinked has unpinned. A global epoch only moves on when all pinned threads have seen the current one, and a node
+// retired in epoch e is freed once the epoch reaches e + 2.
+//
+// pin() takes no locks and doesn't allocate once the thread is registered (which happens on first use, or up front
+// with register_thread(), which real-time threads should call). It is a thread local counter, an atomic exchange
+// and a load; pins nest. Keep pinned sections short: one long pin holds back every free in the process.
+// retire() frees a batch on the calling thread every BatchSize calls, so real-time threads should leave retiring
+// to others where they can.
+namespace epoch
+{
+
+// Retired nodes collected per thread before an attempt to free them
+constexpr uint32_t BatchSize = 64;
+
+// Pinned for its lifetime
+class guard
+{
+public:
+    guard();
+    ~guard();
+
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+};
+
+[[nodiscard]] inline guard pin()
+{
+    return guard();
+}
+
+bool is_pinned();
+
+// Set up this thread's record now, rather than on its first pin or retire
+void register_thread();
+
+// Free p with deleter once no thread can still be reading it. p must already be unreachable for new readers.
+// Deleters may retire more (a node retiring its children); those wait for a later collect
+void retire(void* p, void (*deleter)(void*));
+
+template <class T>
+void retire(T* p)
+{
+    retire(static_cast<void*>(p), [](void* pObject) {
+        delete static_cast<T*>(pObject);
+    });
+}
+
+// Try to move the epoch on and free what this thread retired that is now safe
+void collect();
+
+// Wait until everything this thread has retired (and anything left by exited threads) is freed.
+// For shutdown and tests; never call it while pinned
+void flush();
+
+struct stats
+{
+    uint64_t epoch = 0;
+    uint64_t retired = 0;
+    uint64_t freed = 0;
+    uint32_t threads = 0; // Registered and still running
+
+    uint64_t Pending() const
+    {
+        return retired - freed;
+    }
+};
+
+stats get_stats();
+
+} // namespace epoch
+} // namespace Zest
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Zest
+{
+
+// Move only void() callable.
+// Unlike std::function it accepts move only captures, and anything up to InlineSize bytes
+// is stored in place, so building and moving a job never touches the heap
+class job
+{
+public:
+    static constexpr size_t InlineSize = 64;
+
+    job() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, job>>>
+    job(F&& fn)
+    {
+        using Fn = std::decay_t<F>;
+        static_assert(std::is_invocable_v<Fn&>, "A job must be callable with no arguments");
+
+        if constexpr (fits_inline<Fn>())
+        {
+            new (m_storage) Fn(std::forward<F>(fn));
+            m_pOps = &inline_ops<Fn>;
+        }
+        else
+        {
+            *reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(fn));
+            m_pOps = &heap_ops<Fn>;
+        }
+    }
+
+    job(job&& rhs) noexcept
+    {
+        take(rhs);
+    }
+
+    job& operator=(job&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+            take(rhs);
+        }
+        return *this;
+    }
+
+    job(const job&) = delete;
+    job& operator=(const job&) = delete;
+
+    ~job()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        m_pOps->invoke(m_storage);
+    }
+
+    explicit operator bool() const
+    {
+        return m_pOps != nullptr;
+    }
+
+    bool is_inline() const
+    {
+        return m_pOps && m_pOps->isInline;
+    }
+
+    void reset()
+    {
+        if (m_pOps)
+        {
+            m_pOps->destroy(m_storage);
+            m_pOps = nullptr;
+        }
+    }
+
+private:
+    struct ops
+    {
+        void (*invoke)(void*);
+        void (*move)(void* pDest, void* pSource);
+        void (*destroy)(void*);
+        bool isInline;
+    };
+
+    template <typename Fn>
+    static constexpr bool fits_inline()
+    {
+        return sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static constexpr ops inline_ops = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* pDest, void* pSource) {
+            new (pDest) Fn(std::move(*static_cast<Fn*>(pSource)));
+            static_cast<Fn*>(pSource)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+        true
+    };
+
+    template <typename Fn>
+    static constexpr ops heap_ops = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* pDest, void* pSource) { *static_cast<Fn**>(pDest) = *static_cast<Fn**>(pSource); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+        false
+    };
+
+    void take(job& rhs) noexcept
+    {
+        if (rhs.m_pOps)
+        {
+            rhs.m_pOps->move(m_storage, rhs.m_storage);
+            m_pOps = rhs.m_pOps;
+            rhs.m_pOps = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_storage[InlineSize];
+    const ops* m_pOps = nullptr;
+};
+
+} // namespace Zest
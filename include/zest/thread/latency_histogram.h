@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace Zest
+{
+
+// Log2 histogram of durations, for thread pool and queue telemetry. Bucket b counts durations below
+// latency_histogram_limit_ns(b), and at or above the bucket before; the first holds everything under a microsecond
+constexpr size_t LatencyHistogramBuckets = 32;
+using latency_histogram = std::array<uint64_t, LatencyHistogramBuckets>;
+
+inline int64_t latency_histogram_limit_ns(size_t bucket)
+{
+    return int64_t(1024) << bucket;
+}
+
+inline size_t latency_histogram_bucket(int64_t ns)
+{
+    auto bucket = size_t(std::bit_width(uint64_t(std::max(ns, int64_t(0))) >> 10));
+    return std::min(bucket, LatencyHistogramBuckets - 1);
+}
+
+// For windows: a later snapshot of the same counts, less an earlier one
+inline void latency_histogram_subtract(latency_histogram& histogram, const latency_histogram& earlier)
+{
+    for (size_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++)
+    {
+        histogram[bucket] -= earlier[bucket];
+    }
+}
+
+// Approximate; the upper limit of the bucket holding the fraction p of the samples
+inline int64_t latency_histogram_percentile_ns(const latency_histogram& histogram, double p)
+{
+    uint64_t total = 0;
+    for (auto count : histogram)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    auto target = std::max(uint64_t(std::clamp(p, 0.0, 1.0) * double(total) + 0.5), uint64_t(1));
+    uint64_t sum = 0;
+    for (size_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++)
+    {
+        sum += histogram[bucket];
+        if (sum >= target)
+        {
+            return latency_histogram_limit_ns(bucket);
+        }
+    }
+    return latency_histogram_limit_ns(LatencyHistogramBuckets - 1);
+}
+
+} // namespace Zest
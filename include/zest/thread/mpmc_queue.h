@@ -0,0 +1,516 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <moodycamel/blockingconcurrentqueue.h>
+#include <moodycamel/lightweightsemaphore.h>
+
+#include <zest/thread/latency_histogram.h>
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// Counters from an instrumented mpmc_queue, since it was made. Snapshots subtract to give a window
+struct mpmc_queue_stats
+{
+    uint64_t enqueued = 0;
+    uint64_t dequeued = 0;
+    uint64_t fullWaits = 0;     // Times a producer found a bounded queue full
+    latency_histogram latency{}; // Enqueue to dequeue, per item
+
+    // Items in the queue (for a snapshot), or the change in depth (for a window)
+    int64_t Depth() const
+    {
+        return int64_t(enqueued - dequeued);
+    }
+
+    mpmc_queue_stats Since(const mpmc_queue_stats& before) const
+    {
+        auto window = *this;
+        window.enqueued -= before.enqueued;
+        window.dequeued -= before.dequeued;
+        window.fullWaits -= before.fullWaits;
+        latency_histogram_subtract(window.latency, before.latency);
+        return window;
+    }
+
+    // Approximate; see latency_histogram_percentile_ns
+    int64_t LatencyPercentileNs(double p) const
+    {
+        return latency_histogram_percentile_ns(latency, p);
+    }
+};
+
+// Multi producer, multi consumer queue; the one way Zest code queues between arbitrary threads.
+// A thin layer over moodycamel's BlockingConcurrentQueue, adding:
+// - A bound: with a capacity, producers wait (or fail, or time out) for space, so a slow consumer pushes back
+//   instead of the queue growing without limit. Capacity 0 is unbounded
+// - Blocking and timed waits on both sides, single and bulk
+// - With Instrumented, counts of items in and out, producers held back, and an enqueue to dequeue latency
+//   histogram; each item then carries its enqueue time. Without it there is no overhead
+// Tokens from make_producer_token/make_consumer_token make one thread's repeated use cheaper, as in moodycamel;
+// a producer token also keeps that producer's items in order.
+// Bulk functions take forward iterators; bulk dequeues assign through the output iterator.
+template <class T, bool Instrumented = false>
+class mpmc_queue
+{
+    struct Stamped
+    {
+        T value;
+        int64_t enqueuedNs;
+    };
+    using Item = std::conditional_t<Instrumented, Stamped, T>;
+    using Queue = moodycamel::BlockingConcurrentQueue<Item>;
+    using Semaphore = moodycamel::LightweightSemaphore;
+
+public:
+    using producer_token = moodycamel::ProducerToken;
+    using consumer_token = moodycamel::ConsumerToken;
+
+    explicit mpmc_queue(size_t capacity = 0)
+        : m_queue(capacity ? capacity : 6 * Queue::BLOCK_SIZE)
+        , m_capacity(capacity)
+        , m_slots(typename Semaphore::ssize_t(capacity))
+    {
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    producer_token make_producer_token()
+    {
+        return producer_token(m_queue);
+    }
+
+    consumer_token make_consumer_token()
+    {
+        return consumer_token(m_queue);
+    }
+
+    // 0 when unbounded
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    size_t size_approx() const
+    {
+        return m_queue.size_approx();
+    }
+
+    // Producer. Waits for space when bounded and full
+    template <class U>
+    void enqueue(U&& item)
+    {
+        push(nullptr, std::forward<U>(item), Forever);
+    }
+
+    template <class U>
+    void enqueue(producer_token& token, U&& item)
+    {
+        push(&token, std::forward<U>(item), Forever);
+    }
+
+    // False, and nothing queued, if bounded and full
+    template <class U>
+    bool try_enqueue(U&& item)
+    {
+        return push(nullptr, std::forward<U>(item), 0);
+    }
+
+    template <class U>
+    bool try_enqueue(producer_token& token, U&& item)
+    {
+        return push(&token, std::forward<U>(item), 0);
+    }
+
+    template <class U, class Rep, class Period>
+    bool enqueue_for(U&& item, std::chrono::duration<Rep, Period> timeout)
+    {
+        return push(nullptr, std::forward<U>(item), ToMicroseconds(timeout));
+    }
+
+    template <class U, class Rep, class Period>
+    bool enqueue_for(producer_token& token, U&& item, std::chrono::duration<Rep, Period> timeout)
+    {
+        return push(&token, std::forward<U>(item), ToMicroseconds(timeout));
+    }
+
+    // All of them, as space allows; when bounded they may go in in batches, interleaved with other producers
+    template <class It>
+    void enqueue_bulk(It first, size_t count)
+    {
+        push_bulk(nullptr, first, count, Forever);
+    }
+
+    template <class It>
+    void enqueue_bulk(producer_token& token, It first, size_t count)
+    {
+        push_bulk(&token, first, count, Forever);
+    }
+
+    // As many as fit now, from the front; returns the count queued
+    template <class It>
+    size_t try_enqueue_bulk(It first, size_t count)
+    {
+        return push_bulk(nullptr, first, count, 0);
+    }
+
+    template <class It>
+    size_t try_enqueue_bulk(producer_token& token, It first, size_t count)
+    {
+        return push_bulk(&token, first, count, 0);
+    }
+
+    // Consumer
+    bool try_dequeue(T& item)
+    {
+        return pop([&](auto& receiver) { return m_queue.try_dequeue(receiver); }, item) != 0;
+    }
+
+    bool try_dequeue(consumer_token& token, T& item)
+    {
+        return pop([&](auto& receiver) { return m_queue.try_dequeue(token, receiver); }, item) != 0;
+    }
+
+    void wait_dequeue(T& item)
+    {
+        pop([&](auto& receiver) { m_queue.wait_dequeue(receiver); return true; }, item);
+    }
+
+    void wait_dequeue(consumer_token& token, T& item)
+    {
+        pop([&](auto& receiver) { m_queue.wait_dequeue(token, receiver); return true; }, item);
+    }
+
+    template <class Rep, class Period>
+    bool wait_dequeue_for(T& item, std::chrono::duration<Rep, Period> timeout)
+    {
+        const auto us = ToMicroseconds(timeout);
+        return pop([&](auto& receiver) { return m_queue.wait_dequeue_timed(receiver, us); }, item) != 0;
+    }
+
+    template <class Rep, class Period>
+    bool wait_dequeue_for(consumer_token& token, T& item, std::chrono::duration<Rep, Period> timeout)
+    {
+        const auto us = ToMicroseconds(timeout);
+        return pop([&](auto& receiver) { return m_queue.wait_dequeue_timed(token, receiver, us); }, item) != 0;
+    }
+
+    // Up to max items; returns the count
+    template <class It>
+    size_t try_dequeue_bulk(It first, size_t max)
+    {
+        return pop_bulk([&](auto receiver) { return m_queue.try_dequeue_bulk(receiver, max); }, first);
+    }
+
+    template <class It>
+    size_t try_dequeue_bulk(consumer_token& token, It first, size_t max)
+    {
+        return pop_bulk([&](auto receiver) { return m_queue.try_dequeue_bulk(token, receiver, max); }, first);
+    }
+
+    // At least one, up to max
+    template <class It>
+    size_t wait_dequeue_bulk(It first, size_t max)
+    {
+        return pop_bulk([&](auto receiver) { return m_queue.wait_dequeue_bulk(receiver, max); }, first);
+    }
+
+    template <class It>
+    size_t wait_dequeue_bulk(consumer_token& token, It first, size_t max)
+    {
+        return pop_bulk([&](auto receiver) { return m_queue.wait_dequeue_bulk(token, receiver, max); }, first);
+    }
+
+    template <class It, class Rep, class Period>
+    size_t wait_dequeue_bulk_for(It first, size_t max, std::chrono::duration<Rep, Period> timeout)
+    {
+        const auto us = ToMicroseconds(timeout);
+        return pop_bulk([&](auto receiver) { return m_queue.wait_dequeue_bulk_timed(receiver, max, us); }, first);
+    }
+
+    template <class It, class Rep, class Period>
+    size_t wait_dequeue_bulk_for(consumer_token& token, It first, size_t max, std::chrono::duration<Rep, Period> timeout)
+    {
+        const auto us = ToMicroseconds(timeout);
+        return pop_bulk([&](auto receiver) { return m_queue.wait_dequeue_bulk_timed(token, receiver, max, us); }, first);
+    }
+
+    // Zero unless Instrumented
+    mpmc_queue_stats stats() const
+    {
+        mpmc_queue_stats result;
+        if constexpr (Instrumented)
+        {
+            result.enqueued = m_counters.enqueued.load(std::memory_order_relaxed);
+            result.dequeued = m_counters.dequeued.load(std::memory_order_relaxed);
+            result.fullWaits = m_counters.fullWaits.load(std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++)
+            {
+                result.latency[bucket] = m_counters.latency[bucket].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+
+private:
+    static constexpr int64_t Forever = -1;
+
+    template <class Rep, class Period>
+    static int64_t ToMicroseconds(std::chrono::duration<Rep, Period> timeout)
+    {
+        return std::max(int64_t(0), int64_t(std::chrono::duration_cast<std::chrono::microseconds>(timeout).count()));
+    }
+
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Wraps an input iterator so each item is stamped with one enqueue time
+    template <class It>
+    struct Stamper
+    {
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Item;
+
+        It it;
+        int64_t ns;
+
+        Item operator*() const { return Item{ T(*it), ns }; }
+        Stamper& operator++() { ++it; return *this; }
+        Stamper operator++(int) { auto copy = *this; ++it; return copy; }
+    };
+
+    // Latencies of one dequeue call, added to the shared counters once at the end
+    struct Tally
+    {
+        int64_t nowNs = 0;
+        uint64_t count = 0;
+        latency_histogram latency{};
+    };
+
+    // What the queue assigns dequeued items to; unwraps them into the caller's iterator, noting their latency
+    template <class Out>
+    struct Receiver
+    {
+        using iterator_category = std::output_iterator_tag;
+        using value_type = void;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = void;
+
+        Out out;
+        Tally* pTally;
+
+        Receiver& operator=(Item&& item)
+        {
+            if (!pTally->nowNs)
+            {
+                pTally->nowNs = NowNs();
+            }
+            pTally->latency[latency_histogram_bucket(pTally->nowNs - item.enqueuedNs)]++;
+            pTally->count++;
+            *out = std::move(item.value);
+            return *this;
+        }
+        Receiver& operator*() { return *this; }
+        Receiver& operator++() { ++out; return *this; }
+        Receiver operator++(int) { auto copy = *this; ++out; return copy; }
+    };
+
+    // Space for up to count items; 0 if there is none within the timeout (0 to not wait, Forever)
+    size_t acquire(size_t count, int64_t timeoutUs)
+    {
+        if (!m_capacity || count == 0)
+        {
+            return count;
+        }
+
+        const auto max = typename Semaphore::ssize_t(std::min(count, m_capacity));
+        auto acquired = m_slots.tryWaitMany(max);
+        if (acquired == 0)
+        {
+            if constexpr (Instrumented)
+            {
+                m_counters.fullWaits.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (timeoutUs != 0)
+            {
+                acquired = timeoutUs == Forever ? m_slots.waitMany(max) : m_slots.waitMany(max, timeoutUs);
+            }
+        }
+        return size_t(std::max(acquired, typename Semaphore::ssize_t(0)));
+    }
+
+    void release(size_t count)
+    {
+        if (m_capacity && count)
+        {
+            m_slots.signal(typename Semaphore::ssize_t(count));
+        }
+    }
+
+    template <class U>
+    bool push(producer_token* pToken, U&& item, int64_t timeoutUs)
+    {
+        if (acquire(1, timeoutUs) == 0)
+        {
+            return false;
+        }
+
+        bool queued;
+        if constexpr (Instrumented)
+        {
+            queued = pToken ? m_queue.enqueue(*pToken, Item{ T(std::forward<U>(item)), NowNs() }) : m_queue.enqueue(Item{ T(std::forward<U>(item)), NowNs() });
+        }
+        else
+        {
+            queued = pToken ? m_queue.enqueue(*pToken, std::forward<U>(item)) : m_queue.enqueue(std::forward<U>(item));
+        }
+        counted_push(queued ? 1 : 0, 1);
+        return queued;
+    }
+
+    template <class It>
+    size_t push_bulk(producer_token* pToken, It first, size_t count, int64_t timeoutUs)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            auto batch = acquire(count - done, timeoutUs);
+            if (batch == 0)
+            {
+                break;
+            }
+
+            bool queued;
+            if constexpr (Instrumented)
+            {
+                Stamper<It> stamper{ first, NowNs() };
+                queued = pToken ? m_queue.enqueue_bulk(*pToken, stamper, batch) : m_queue.enqueue_bulk(stamper, batch);
+            }
+            else
+            {
+                queued = pToken ? m_queue.enqueue_bulk(*pToken, first, batch) : m_queue.enqueue_bulk(first, batch);
+            }
+            counted_push(queued ? batch : 0, batch);
+            if (!queued)
+            {
+                break;
+            }
+
+            std::advance(first, batch);
+            done += batch;
+        }
+        return done;
+    }
+
+    // Hand back space reserved for items that didn't go in, and count the ones that did
+    void counted_push(size_t queued, size_t reserved)
+    {
+        release(reserved - queued);
+        if constexpr (Instrumented)
+        {
+            m_counters.enqueued.fetch_add(queued, std::memory_order_relaxed);
+        }
+    }
+
+    void counted_pop(size_t count, const Tally& tally)
+    {
+        release(count);
+        if constexpr (Instrumented)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            m_counters.dequeued.fetch_add(count, std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++)
+            {
+                if (tally.latency[bucket])
+                {
+                    m_counters.latency[bucket].fetch_add(tally.latency[bucket], std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    template <class Fn>
+    size_t pop(Fn fn, T& item)
+    {
+        Tally tally;
+        size_t count;
+        if constexpr (Instrumented)
+        {
+            Receiver<T*> receiver{ &item, &tally };
+            count = fn(receiver) ? 1 : 0;
+        }
+        else
+        {
+            count = fn(item) ? 1 : 0;
+        }
+        counted_pop(count, tally);
+        return count;
+    }
+
+    template <class Fn, class It>
+    size_t pop_bulk(Fn fn, It first)
+    {
+        Tally tally;
+        size_t count;
+        if constexpr (Instrumented)
+        {
+            count = fn(Receiver<It>{ first, &tally });
+        }
+        else
+        {
+            count = fn(first);
+        }
+        counted_pop(count, tally);
+        return count;
+    }
+
+    struct Counters
+    {
+        alignas(cache_line_size) std::atomic<uint64_t> enqueued = 0;
+        alignas(cache_line_size) std::atomic<uint64_t> dequeued = 0;
+        std::atomic<uint64_t> fullWaits = 0;
+        std::array<std::atomic<uint64_t>, LatencyHistogramBuckets> latency{};
+    };
+
+    // Takes no space, and no cache line alignment, when not instrumented
+    struct NoCounters
+    {
+    };
+
+    Queue m_queue;
+    const size_t m_capacity;
+    Semaphore m_slots;
+    [[no_unique_address]] std::conditional_t<Instrumented, Counters, NoCounters> m_counters;
+};
+
+// Bounded, with backpressure; the capacity is required
+template <class T, bool Instrumented = false>
+class bounded_mpmc_queue : public mpmc_queue<T, Instrumented>
+{
+public:
+    explicit bounded_mpmc_queue(size_t capacity)
+        : mpmc_queue<T, Instrumented>(std::max(capacity, size_t(1)))
+    {
+    }
+};
+
+} // namespace Zest
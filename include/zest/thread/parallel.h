@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <exception>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/thread_utils.h>
+#include <zest/thread/threadpool.h>
+
+namespace Zest
+{
+
+// Data parallel helpers on a TPool.
+// Ranges are split in half until they reach the grain size; one half is queued and the caller carries on with the other,
+// so the submitting thread always does work. Waiting threads run queued tasks instead of blocking, which makes it safe
+// to call these from inside a pool task (nested parallelism can't starve the pool).
+// A grain of 0 picks one based on the range and the number of workers.
+
+namespace detail
+{
+
+struct parallel_state
+{
+    std::atomic<size_t> pending = 0;
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+};
+
+inline size_t parallel_grain(const TPool& pool, size_t count, size_t grain)
+{
+    if (grain != 0)
+    {
+        return grain;
+    }
+
+    // Several chunks per thread leaves room to balance uneven work
+    return std::max(count / ((pool.thread_count() + 1) * 8), size_t(1));
+}
+
+template <typename Body>
+void parallel_run_chunk(parallel_state& state, const Body& body, size_t begin, size_t end)
+{
+    if (state.failed.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    try
+    {
+        body(begin, end);
+    }
+    catch (...)
+    {
+        // First failure wins; the rest of the range is skipped
+        if (!state.failed.exchange(true))
+        {
+            state.error = std::current_exception();
+        }
+    }
+}
+
+template <typename Body>
+void parallel_split(TPool& pool, parallel_state& state, const Body& body, size_t begin, size_t end, size_t grain)
+{
+    while ((end - begin) > grain)
+    {
+        auto mid = begin + (end - begin) / 2;
+        state.pending.fetch_add(1, std::memory_order_relaxed);
+        pool.submit([&pool, &state, &body, mid, end, grain]() {
+            parallel_split(pool, state, body, mid, end, grain);
+            state.pending.fetch_sub(1, std::memory_order_release);
+        });
+        end = mid;
+    }
+    parallel_run_chunk(state, body, begin, end);
+}
+
+// Calls body(begin, end) over chunks of [begin, end), returning when all are done
+template <typename Body>
+void parallel_chunks(TPool& pool, size_t begin, size_t end, size_t grain, const Body& body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    grain = parallel_grain(pool, end - begin, grain);
+    if (pool.thread_count() == 0 || (end - begin) <= grain)
+    {
+        body(begin, end);
+        return;
+    }
+
+    parallel_state state;
+    parallel_split(pool, state, body, begin, end, grain);
+
+    // Help out rather than block, so nested calls keep the pool moving
+    while (state.pending.load(std::memory_order_acquire) != 0)
+    {
+        if (!pool.try_run_one())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state.error)
+    {
+        std::rethrow_exception(state.error);
+    }
+}
+
+} // namespace detail
+
+// fn(index) for each index in [begin, end)
+template <std::integral Index, typename Fn>
+void parallel_for(TPool& pool, Index begin, Index end, size_t grain, Fn&& fn)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    detail::parallel_chunks(pool, 0, size_t(end - begin), grain, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (auto index = chunkBegin; index < chunkEnd; index++)
+        {
+            fn(Index(begin + Index(index)));
+        }
+    });
+}
+
+// fn(item) for each item in the span
+template <typename T, typename Fn>
+void parallel_for(TPool& pool, std::span<T> items, size_t grain, Fn&& fn)
+{
+    detail::parallel_chunks(pool, 0, items.size(), grain, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (auto index = chunkBegin; index < chunkEnd; index++)
+        {
+            fn(items[index]);
+        }
+    });
+}
+
+// out[i] = fn(in[i]); the spans must be the same size
+template <typename In, typename Out, typename Fn>
+void parallel_transform(TPool& pool, std::span<In> in, std::span<Out> out, size_t grain, Fn&& fn)
+{
+    assert(in.size() == out.size());
+    detail::parallel_chunks(pool, 0, std::min(in.size(), out.size()), grain, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (auto index = chunkBegin; index < chunkEnd; index++)
+        {
+            out[index] = fn(in[index]);
+        }
+    });
+}
+
+// Folds map(index) over [begin, end) with reduce. Each chunk starts from identity, so it must not change
+// a value when reduced with it (0 for +, 1 for *).
+// Chunks are folded in order, so the result doesn't depend on scheduling even for floating point
+template <std::integral Index, typename T, typename Map, typename Reduce>
+T parallel_reduce(TPool& pool, Index begin, Index end, size_t grain, T identity, Map&& map, Reduce&& reduce)
+{
+    if (end <= begin)
+    {
+        return identity;
+    }
+
+    const auto count = size_t(end - begin);
+    grain = detail::parallel_grain(pool, count, grain);
+
+    // A line each, so chunks finishing side by side don't share one (and vector<bool> can't pack them into a word)
+    struct alignas(cache_line_size) Partial
+    {
+        T value;
+    };
+
+    const auto chunks = (count + grain - 1) / grain;
+    std::vector<Partial> partials(chunks, Partial{ identity });
+    detail::parallel_chunks(pool, 0, chunks, 1, [&](size_t chunkBegin, size_t chunkEnd) {
+        for (auto chunk = chunkBegin; chunk < chunkEnd; chunk++)
+        {
+            auto partial = identity;
+            auto last = std::min((chunk + 1) * grain, count);
+            for (auto index = chunk * grain; index < last; index++)
+            {
+                partial = reduce(partial, map(Index(begin + Index(index))));
+            }
+            partials[chunk].value = partial;
+        }
+    });
+
+    auto result = identity;
+    for (auto& partial : partials)
+    {
+        result = reduce(result, partial.value);
+    }
+    return result;
+}
+
+// Folds map(item) over the span with reduce
+template <typename Item, typename T, typename Map, typename Reduce>
+T parallel_reduce(TPool& pool, std::span<Item> items, size_t grain, T identity, Map&& map, Reduce&& reduce)
+{
+    return parallel_reduce(pool, size_t(0), items.size(), grain, identity, [&](size_t index) {
+        return map(items[index]);
+    }, reduce);
+}
+
+} // namespace Zest
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// Sequence lock for small, trivially copyable snapshots (a few words), e.g. timing state published by one thread
+// and read by the audio and UI threads. Readers never write shared memory, so they don't slow each other or the
+// writer down; they copy the value and retry if a write overlapped. Writers never wait for readers; concurrent
+// writers take turns on the sequence. The sequence is odd while a write is in progress.
+// The value is held as relaxed atomic words, so the racing copy is well defined; on 64 bit targets these are plain loads
+// and stores. Not for large T: a reader retries for as long as writes keep landing during its copy
+template <class T>
+class seqlock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshots are copied as words");
+
+public:
+    seqlock()
+        : seqlock(T{})
+    {
+    }
+
+    explicit seqlock(const T& value)
+    {
+        write_words(value);
+    }
+
+    seqlock(const seqlock&) = delete;
+    seqlock& operator=(const seqlock&) = delete;
+
+    T load() const
+    {
+        T value;
+        while (!try_load(value))
+        {
+            cpu_relax();
+        }
+        return value;
+    }
+
+    // One attempt; false if a write was in progress or overlapped the copy, and value is then unspecified
+    bool try_load(T& value) const
+    {
+        const auto before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            return false;
+        }
+
+        std::array<uint64_t, Words> words;
+        for (size_t index = 0; index < Words; index++)
+        {
+            words[index] = m_words[index].load(std::memory_order_relaxed);
+        }
+
+        // Keep the copy above the re-check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before)
+        {
+            return false;
+        }
+
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return true;
+    }
+
+    void store(const T& value)
+    {
+        auto sequence = lock();
+        write_words(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Read, modify and publish as one write; fn takes a T& and shouldn't block
+    template <class Fn>
+    void update(Fn&& fn)
+    {
+        auto sequence = lock();
+        T value;
+        std::array<uint64_t, Words> words;
+        for (size_t index = 0; index < Words; index++)
+        {
+            words[index] = m_words[index].load(std::memory_order_relaxed);
+        }
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+
+        fn(value);
+
+        write_words(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Even, and changes with every write
+    uint64_t version() const
+    {
+        return m_sequence.load(std::memory_order_acquire) & ~uint64_t(1);
+    }
+
+private:
+    static constexpr size_t Words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Make the sequence odd, waiting for any other writer; returns the even value it was
+    uint64_t lock()
+    {
+        auto sequence = m_sequence.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if (!(sequence & 1) && m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                break;
+            }
+            cpu_relax();
+            sequence = m_sequence.load(std::memory_order_relaxed);
+        }
+
+        // Readers that see the new words must also see the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence;
+    }
+
+    void write_words(const T& value)
+    {
+        std::array<uint64_t, Words> words{};
+        std::memcpy(words.data(), static_cast<const void*>(&value), sizeof(T));
+        for (size_t index = 0; index < Words; index++)
+        {
+            m_words[index].store(words[index], std::memory_order_relaxed);
+        }
+    }
+
+    alignas(cache_line_size) std::atomic<uint64_t> m_sequence = 0;
+    std::array<std::atomic<uint64_t>, Words> m_words;
+};
+
+} // namespace Zest
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include <zest/algorithm/ring_buffer.h>
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// Wait-free single producer, single consumer ring; e.g. parameter changes from the UI to the audio thread, meters back.
+// Storage is allocated once in the constructor; nothing after that allocates, locks or waits. Unlike ring_buffer it
+// never drops data: writes that don't fit are cut short. Capacity is rounded up to a power of two so indices are masked.
+// The indices count up forever and are each written by one side only, with release, and read by the other with acquire.
+template <class T>
+class spsc_ring_buffer
+{
+public:
+    explicit spsc_ring_buffer(size_t capacity)
+        : m_capacity(std::bit_ceil(std::max(capacity, size_t(1))))
+        , m_mask(m_capacity - 1)
+        , m_data(std::make_unique<T[]>(m_capacity))
+    {
+    }
+
+    spsc_ring_buffer(const spsc_ring_buffer&) = delete;
+    spsc_ring_buffer& operator=(const spsc_ring_buffer&) = delete;
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    // A snapshot; the other side may be moving. Tail first, so it can't pass the head we read
+    size_t size() const
+    {
+        const auto tail = m_tail.load(std::memory_order_acquire);
+        return m_head.load(std::memory_order_acquire) - tail;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Producer
+    bool push(const T& item)
+    {
+        auto space = write_prepare(1);
+        if (space.empty())
+        {
+            return false;
+        }
+        space.first[0] = item;
+        write_commit(1);
+        return true;
+    }
+
+    // Copies in as much as fits; returns the count written
+    size_t write(std::span<const T> items)
+    {
+        auto space = write_prepare(items.size());
+        std::copy_n(items.begin(), space.first.size(), space.first.begin());
+        std::copy_n(items.begin() + space.first.size(), space.second.size(), space.second.begin());
+        write_commit(space.size());
+        return space.size();
+    }
+
+    // Free space, up to maxCount, to fill in place before write_commit
+    ring_span<T> write_prepare(size_t maxCount = SIZE_MAX)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (m_capacity - (head - m_tailCache) < maxCount)
+        {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+        }
+        return segments(head, std::min(maxCount, m_capacity - (head - m_tailCache)));
+    }
+
+    void write_commit(size_t count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer
+    bool pop(T& item)
+    {
+        auto items = read_prepare(1);
+        if (items.empty())
+        {
+            return false;
+        }
+        item = items.first[0];
+        read_commit(1);
+        return true;
+    }
+
+    // Copies out as much as is there, up to the size of items; returns the count read
+    size_t read(std::span<T> items)
+    {
+        auto available = read_prepare(items.size());
+        available.copy_to(items);
+        read_commit(available.size());
+        return available.size();
+    }
+
+    // Readable items, up to maxCount, to use in place before read_commit
+    ring_span<const T> read_prepare(size_t maxCount = SIZE_MAX)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (m_headCache - tail < maxCount)
+        {
+            m_headCache = m_head.load(std::memory_order_acquire);
+        }
+        auto run = segments(tail, std::min(maxCount, m_headCache - tail));
+        return { run.first, run.second };
+    }
+
+    void read_commit(size_t count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    ring_span<T> segments(size_t start, size_t count) const
+    {
+        const auto offset = start & m_mask;
+        const auto first = std::min(count, m_capacity - offset);
+        return { std::span<T>(m_data.get() + offset, first), std::span<T>(m_data.get(), count - first) };
+    }
+
+    // Each side's index, and its cached copy of the other's, share a line that only that side writes
+    alignas(cache_line_size) std::atomic<size_t> m_head = 0;
+    size_t m_tailCache = 0;
+
+    alignas(cache_line_size) std::atomic<size_t> m_tail = 0;
+    size_t m_headCache = 0;
+
+    alignas(cache_line_size) const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_data;
+};
+
+} // namespace Zest
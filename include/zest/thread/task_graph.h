@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <zest/thread/job.h>
+#include <zest/thread/threadpool.h>
+
+namespace Zest
+{
+
+// A DAG of tasks declared once and run many times, e.g. once per frame.
+// Each node has an atomic count of unfinished predecessors; the worker that finishes a node carries straight on
+// with the first successor it releases and queues any others.
+// Every node is a profile scope. After a run the critical path (longest chain of node times) is recorded; its length
+// goes to a counter track named after the graph, and on the next run the nodes on it are drawn in the critical color.
+class task_graph
+{
+public:
+    using node_id = uint32_t;
+
+    struct node_timing
+    {
+        int64_t startTime = 0;
+        int64_t endTime = 0;
+    };
+
+    // The name must be a static string, it is used for profiling
+    explicit task_graph(const char* pszName = "TaskGraph");
+
+    task_graph(const task_graph&) = delete;
+    task_graph& operator=(const task_graph&) = delete;
+
+    // Node names must also be static strings
+    node_id add(const char* pszName, Zest::job&& fn);
+
+    // before must finish before after starts
+    void precede(node_id before, node_id after);
+
+    void clear();
+
+    // Runs every node once; returns when all are done, running graph work on the calling thread while it waits.
+    // Rethrows the first exception a node threw; nodes after a failure are skipped
+    void run(TPool& pool);
+
+    size_t size() const
+    {
+        return m_nodes.size();
+    }
+
+    const char* name(node_id id) const;
+
+    // Results of the last run; times are nanoseconds on the steady clock
+    const node_timing& timing(node_id id) const;
+    const std::vector<node_id>& critical_path() const
+    {
+        return m_criticalPath;
+    }
+    int64_t critical_path_time() const
+    {
+        return m_criticalTime;
+    }
+
+private:
+    struct node
+    {
+        const char* pszName = nullptr;
+        uint32_t color = 0;
+        Zest::job fn;
+        std::vector<node_id> successors;
+        std::vector<node_id> predecessors;
+        std::unique_ptr<std::atomic<uint32_t>> remaining = std::make_unique<std::atomic<uint32_t>>(0);
+        node_timing timing;
+        bool critical = false;
+    };
+
+    void prepare();
+    void execute(node_id id);
+    void update_critical_path();
+
+private:
+    const char* m_pszName;
+    std::vector<node> m_nodes;
+    std::vector<node_id> m_roots;
+    std::vector<node_id> m_order;
+    bool m_dirty = true;
+
+    // State for the run in progress
+    TPool* m_pPool = nullptr;
+    std::atomic<size_t> m_pending = 0;
+    std::atomic<bool> m_failed = false;
+    std::exception_ptr m_error;
+
+    std::vector<node_id> m_criticalPath;
+    int64_t m_criticalTime = 0;
+};
+
+} // namespace Zest
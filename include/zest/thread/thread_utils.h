@@ -18,6 +18,10 @@
 
 namespace Zest
 {
+
+// Padding used to keep independently written atomics off each other's cache lines
+constexpr size_t cache_line_size = 64;
+
 template <typename R>
 bool is_future_ready(std::future<R> const& f)
 {
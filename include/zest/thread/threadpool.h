@@ -24,115 +24,359 @@ freely, subject to the following restrictions:
 /*
 CM: Note: Modified from the original to support query of the threads available on the machine,
 and fallback to using single threaded if not possible.
+The single locked queue has since been replaced with a work stealing scheduler:
+- Each worker owns a Chase-Lev deque; tasks submitted from a worker go to its own deque.
+- Tasks submitted from other threads go to a global injection queue.
+- Idle workers steal from random victims, spin for a while, then park until woken.
+- Tasks are Zest::job (small buffer, move only) held in recycled nodes, so submit() doesn't allocate.
+- Telemetry (queue depth, wait and run time histograms, busy time) is counted in per-worker shards and only summed when read.
+- In elastic mode workers are added when tasks wait too long or workers block, and retire when idle.
+- Tasks go in priority lanes. Workers drain higher lanes first, but every so often look bottom up so background work
+  can't starve. The real-time lane can have its own workers which never run anything else.
 Original here: https://github.com/progschj/TPool
 */
 
 #pragma once
 
 // containers
+#include <array>
 #include <vector>
-#include <queue>
 // threading
-#include <thread>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
+#include <condition_variable>
 #include <future>
+#include <mutex>
+#include <thread>
 // utility wrappers
-#include <memory>
+#include <chrono>
 #include <functional>
-// exceptions
-#include <stdexcept>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <zest/thread/cpu_topology.h>
+#include <zest/thread/job.h>
+#include <zest/thread/latency_histogram.h>
+#include <zest/thread/thread_utils.h>
+#include <zest/thread/ws_deque.h>
+
+struct TPoolSettings
+{
+    // General workers; with one or fewer, tasks outside the real-time lane run inline on submit
+    size_t threads = std::thread::hardware_concurrency();
+
+    // Extra workers which only ever run real-time lane tasks
+    size_t realTimeThreads = 0;
+
+    // Elastic mode, when above threads. Workers are added up to maxThreads while queued tasks wait longer than
+    // growLatency or workers sit in blocking regions, and retire down to threads after idleTimeout without work
+    size_t maxThreads = 0;
+    std::chrono::microseconds growLatency = std::chrono::milliseconds(2);
+    std::chrono::milliseconds idleTimeout = std::chrono::seconds(5);
+
+    // Workers are named "<name> <index>" for the OS and the profiler
+    const char* name = "TPool";
+
+    // Placement; see cpu_pin_plan. Reserved cores are kept free of workers, see pin_thread_away_from_workers
+    Zest::CpuPinPolicy pinPolicy = Zest::CpuPinPolicy::None;
+    uint32_t reservedCores = 0;
+    uint32_t pinDomain = 0;
+};
 
 // std::thread pool for resources recycling
-class TPool {
+class TPool
+{
 public:
-    // the constructor just launches some amount of workers
-    TPool(size_t threads_n = std::thread::hardware_concurrency()) : stop(false)
+    enum class Lane : uint32_t
     {
-        // If not enough threads, the pool will just execute all tasks immediately
-        if (threads_n > 1)
+        RealTime,
+        High,
+        Normal,
+        Background,
+        Count
+    };
+    static constexpr size_t LaneCount = size_t(Lane::Count);
+
+    // Time spent queued by tasks taken from a lane
+    struct LaneStats
+    {
+        uint64_t tasks = 0;
+        int64_t totalWaitNs = 0;
+        int64_t maxWaitNs = 0;
+
+        double MeanWaitNs() const
         {
-            this->workers.reserve(threads_n);
-            for (; threads_n; --threads_n)
-                this->workers.emplace_back(
-                    [this]
+            return tasks ? double(totalWaitNs) / tasks : 0.0;
+        }
+    };
+
+    // Log2 histograms; bucket b counts durations below HistogramLimitNs(b), and at or above the bucket before
+    static constexpr size_t HistogramBuckets = Zest::LatencyHistogramBuckets;
+    using Histogram = Zest::latency_histogram;
+
+    static int64_t HistogramLimitNs(size_t bucket)
+    {
+        return Zest::latency_histogram_limit_ns(bucket);
+    }
+
+    // Approximate; the upper limit of the bucket holding the fraction p of the samples
+    static int64_t HistogramPercentileNs(const Histogram& histogram, double p)
+    {
+        return Zest::latency_histogram_percentile_ns(histogram, p);
+    }
+
+    struct WorkerTelemetry
+    {
+        uint64_t tasks = 0;
+        int64_t busyNs = 0;
+        bool realTime = false;
+        bool running = false;
+    };
+
+    // Counters since the pool started, summed from per-worker shards. Snapshots subtract to give a window
+    struct Telemetry
+    {
+        int64_t timeNs = 0;
+        uint64_t enqueued = 0;
+        uint64_t started = 0;
+        uint64_t queueDepth = 0; // Queued but not started; a level, not a count, so Since() keeps the later one
+        Histogram waitHistogram{};
+        Histogram runHistogram{};
+        std::vector<WorkerTelemetry> workers;
+
+        Telemetry Since(const Telemetry& earlier) const;
+
+        double EnqueueRate() const;
+        double BusyFraction(size_t worker) const;
+    };
+
+    // Cheap to collect; only this walks the shards
+    Telemetry telemetry() const;
+
+    // Call about once a frame. Refreshes the window shown by show_telemetry and writes profiler counter tracks
+    void update_telemetry();
+
+    // ImGui widgets for the current window
+    void show_telemetry();
+
+    // Marks a task that may block (I/O, locks, waiting on another pool) so an elastic pool can cover for it
+    class BlockingRegion
+    {
+    public:
+        explicit BlockingRegion(TPool& pool)
+            : m_pool(pool)
+            , m_counted(pool.begin_blocking())
+        {
+        }
+
+        ~BlockingRegion()
+        {
+            if (m_counted)
             {
-                while (true)
-                {
-                    std::function<void()> task;
-
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock,
-                            [this] { return this->stop || !this->tasks.empty(); });
-                        if (this->stop && this->tasks.empty())
-                            return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-
-                    task();
-                }
+                m_pool.end_blocking();
             }
-            );
         }
-    }
+
+        BlockingRegion(const BlockingRegion&) = delete;
+        BlockingRegion& operator=(const BlockingRegion&) = delete;
+
+    private:
+        TPool& m_pool;
+        bool m_counted;
+    };
+
+    // the constructor just launches some amount of workers
+    TPool(size_t threads_n = std::thread::hardware_concurrency());
+    explicit TPool(const TPoolSettings& settings);
+
     // deleted copy&move ctors&assignments
     TPool(const TPool&) = delete;
     TPool& operator=(const TPool&) = delete;
     TPool(TPool&&) = delete;
     TPool& operator=(TPool&&) = delete;
+
+    // the destructor runs any remaining work and joins all threads
+    virtual ~TPool();
+
     // add new work item to the pool
-    template<class F, class... Args>
-    #if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
-    std::future<typename std::invoke_result<F, Args...>::type> enqueue(F&& f, Args&&... args)
-    #else
-    std::future<typename std::result_of<F(Args...)>::type> enqueue(F&& f, Args&&... args)
-    #endif
-    {
-        #if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
-        using packaged_task_t = std::packaged_task<typename std::invoke_result<F, Args...>::type()>;
-        #else
-        using packaged_task_t = std::packaged_task<typename std::result_of<F(Args...)>::type ()>;
-        #endif
-
-        std::shared_ptr<packaged_task_t> task(new packaged_task_t(
-                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-            ));
-
-        // If there are no works, just run the task in the main thread and return
-        if (workers.empty())
-        {
-            (*task)();
-            return task->get_future();
-        }
-        auto res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(this->queue_mutex);
-            this->tasks.emplace([task](){ (*task)(); });
-        }
-        this->condition.notify_one();
+    template <class F, class... Args>
+    std::future<std::invoke_result_t<F, Args...>> enqueue(F&& f, Args&&... args)
+    {
+        std::packaged_task<std::invoke_result_t<F, Args...>()> task(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+        auto res = task.get_future();
+        submit([task = std::move(task)]() mutable { task(); });
         return res;
     }
-    // the destructor joins all threads
-    virtual ~TPool()
+
+    // Fire and forget; no future, and no allocation for captures that fit in a Zest::job
+    void submit(Zest::job&& fn, Lane lane = Lane::Normal);
+
+    template <class F>
+    void submit(F&& fn, Lane lane = Lane::Normal)
+    {
+        submit(Zest::job(std::forward<F>(fn)), lane);
+    }
+
+    // Queue many tasks with a single lock and a single wakeup; the tasks are moved from
+    void submit_batch(std::span<Zest::job> tasks, Lane lane = Lane::Normal);
+
+    // Run one pending task on the calling thread, if there is one.
+    // Useful to make progress while waiting on work that is still queued.
+    bool try_run_one();
+
+    // General worker slots; in elastic mode the most that can run at once
+    size_t thread_count() const
+    {
+        return m_generalCount;
+    }
+
+    // General workers currently running
+    size_t active_thread_count() const
     {
-        this->stop = true;
-        this->condition.notify_all();
-        for(std::thread& worker : this->workers)
-            worker.join();
+        return m_active.load(std::memory_order_relaxed);
     }
+
+    size_t blocked_thread_count() const
+    {
+        return m_blocked.load(std::memory_order_relaxed);
+    }
+
+    bool is_elastic() const
+    {
+        return m_elastic;
+    }
+
+    // Prefer BlockingRegion. Returns false if the calling thread isn't counted, i.e. not a general worker of an elastic pool
+    bool begin_blocking();
+    void end_blocking();
+
+    size_t realtime_thread_count() const
+    {
+        return m_workers.size() - m_generalCount;
+    }
+
+    // CPUs no worker is pinned to; the reserved cores if there are any
+    std::vector<uint32_t> free_cpus() const;
+
+    // Keep a latency sensitive thread (e.g. audio) off the workers' CPUs. Returns false if the workers aren't pinned
+    bool pin_thread_away_from_workers() const;
+
+    // Summed over the workers since the last reset; approximate while tasks are running
+    LaneStats lane_stats(Lane lane) const;
+
+    // Starts a new window. The workers' counters are left alone; this moves the baseline lane_stats subtracts
+    void reset_lane_stats();
+
+    // Opaque queue node, defined in threadpool.cpp
+    struct TaskNode;
+
 private:
-    // need to keep track of threads so we can join them
-    std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::function<void()> > tasks;
-
-    // synchronization
-    std::mutex queue_mutex;
-    std::condition_variable condition;
+    // Totals since the pool started; only the thread running the task writes them (relaxed load and store on a
+    // worker, atomic adds for the shared external set), and reset_lane_stats never does.
+    // maxWait packs the reset generation it belongs to above the wait, as a max can't be subtracted out
+    struct LaneCounters
+    {
+        std::atomic<uint64_t> tasks = 0;
+        std::atomic<int64_t> totalWaitNs = 0;
+        std::atomic<uint64_t> maxWait = 0;
+    };
+
+    // One writer each, except the shard for threads outside the pool
+    struct alignas(Zest::cache_line_size) TelemetryShard
+    {
+        std::atomic<uint64_t> enqueued = 0;
+        std::atomic<uint64_t> started = 0;
+        std::atomic<int64_t> busyNs = 0;
+        std::array<std::atomic<uint64_t>, HistogramBuckets> wait{};
+        std::array<std::atomic<uint64_t>, HistogramBuckets> runTime{};
+    };
+
+    struct Worker
+    {
+        // Deques for the lanes below real time; real-time tasks always go through the injection queue
+        std::array<Zest::ws_deque<TaskNode*>, LaneCount> tasks;
+        std::array<LaneCounters, LaneCount> laneCounters;
+        TelemetryShard telemetry;
+        bool realTime = false;
+        std::atomic<bool> running = false;
+        std::vector<uint32_t> cpus;
+        uint64_t picks = 0;
+        uint64_t rng = 0;
+        std::thread thread;
+    };
+
+    struct alignas(Zest::cache_line_size) InjectQueue
+    {
+        std::mutex mutex;
+        TaskNode* pHead = nullptr;
+        TaskNode* pTail = nullptr;
+        std::atomic<size_t> count = 0;
+    };
+
+    // Sleepers wait for the epoch to change
+    struct alignas(Zest::cache_line_size) ParkingLot
+    {
+        std::atomic<uint32_t> epoch = 0;
+        std::atomic<uint32_t> sleepers = 0;
+    };
+
+    void start(const TPoolSettings& settings);
+    void worker_loop(uint32_t index);
+    void launch(uint32_t index);
+    bool spawn_worker();
+    void maybe_grow();
+    bool park_timed(ParkingLot& lot, uint32_t epoch);
+    void push_chain(TaskNode* pHead, TaskNode* pTail, size_t count, Lane lane);
+    void wake(ParkingLot& lot, size_t count);
+    TaskNode* find_task(Worker* pSelf);
+    TaskNode* find_in_lane(Worker* pSelf, size_t lane);
+    TaskNode* pop_injected(size_t lane);
+    TaskNode* steal(Worker* pSelf, size_t lane);
+    Worker* current_worker() const;
+    void run(Worker* pSelf, TaskNode* pNode);
+
+private:
+    // Fixed at construction; the deques live as long as the pool. General workers come first
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    size_t m_generalCount = 0;
+    std::string m_name;
+    std::vector<uint32_t> m_reservedCpus;
+
+    // Submissions from outside the pool, and all real-time tasks
+    std::array<InjectQueue, LaneCount> m_inject;
+
+    ParkingLot m_generalLot;
+    ParkingLot m_realTimeLot;
+
+    // Elastic mode; general workers park on the condition variable so idle ones can time out
+    bool m_elastic = false;
+    size_t m_minThreads = 0;
+    int64_t m_growLatencyNs = 0;
+    std::chrono::milliseconds m_idleTimeout{};
+    std::atomic<size_t> m_active = 0;
+    std::atomic<size_t> m_blocked = 0;
+    std::atomic<int64_t> m_lastGrowNs = 0;
+    std::mutex m_spawnMutex;
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCondition;
+
+    // Stats for tasks run by threads outside the pool through try_run_one
+    std::array<LaneCounters, LaneCount> m_externalCounters;
+
+    // Lane totals at the last reset_lane_stats, and how many resets there have been
+    mutable std::mutex m_laneStatsMutex;
+    std::array<LaneStats, LaneCount> m_laneBaseline{};
+    std::atomic<uint64_t> m_laneGeneration = 0;
+    TelemetryShard m_externalTelemetry;
+
+    int64_t m_startNs = 0;
+    std::mutex m_telemetryMutex;
+    Telemetry m_telemetryLast;
+    Telemetry m_telemetryWindow;
+    std::array<const char*, 4> m_counterNames{};
+
     // workers finalization flag
-    std::atomic_bool stop;
+    std::atomic_bool m_stop = false;
 };
-
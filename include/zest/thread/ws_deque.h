@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+
+// Chase-Lev work stealing deque.
+// The owning thread pushes and pops at the bottom; any thread may steal from the top.
+// Memory orderings follow Le, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models"
+template <typename T>
+class ws_deque
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ws_deque items must be trivially copyable, store pointers or indices");
+
+    struct array
+    {
+        explicit array(int64_t size)
+            : capacity(size)
+            , mask(size - 1)
+            , items(new std::atomic<T>[size])
+        {
+            assert((size & (size - 1)) == 0);
+        }
+
+        T get(int64_t index) const
+        {
+            return items[index & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T item)
+        {
+            items[index & mask].store(item, std::memory_order_relaxed);
+        }
+
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+public:
+    explicit ws_deque(int64_t capacity = 1024)
+        : m_array(new array(capacity))
+    {
+    }
+
+    ~ws_deque()
+    {
+        delete m_array.load(std::memory_order_relaxed);
+    }
+
+    ws_deque(const ws_deque&) = delete;
+    ws_deque& operator=(const ws_deque&) = delete;
+
+    // Owner only
+    void push(T item)
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_acquire);
+        auto pArray = m_array.load(std::memory_order_relaxed);
+
+        if (bottom - top > pArray->capacity - 1)
+        {
+            pArray = grow(pArray, bottom, top);
+        }
+
+        pArray->put(bottom, item);
+
+        // A release store rather than the paper's release fence; same cost on x86 and visible to ThreadSanitizer
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Owner only; LIFO, so the most recently pushed (and cache warm) item comes back first
+    std::optional<T> pop()
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        auto pArray = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        std::optional<T> item = pArray->get(bottom);
+        if (top == bottom)
+        {
+            // Last item; race the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                item.reset();
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread; FIFO from the top
+    std::optional<T> steal()
+    {
+        auto top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+        {
+            return std::nullopt;
+        }
+
+        auto pArray = m_array.load(std::memory_order_acquire);
+        T item = pArray->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            // Lost to another thief or the owner
+            return std::nullopt;
+        }
+        return item;
+    }
+
+    // Approximate when called from a thread that isn't the owner
+    int64_t size() const
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_relaxed);
+        return std::max(bottom - top, int64_t(0));
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+private:
+    array* grow(array* pArray, int64_t bottom, int64_t top)
+    {
+        auto pNew = new array(pArray->capacity * 2);
+        for (auto index = top; index != bottom; index++)
+        {
+            pNew->put(index, pArray->get(index));
+        }
+
+        // Thieves may still be reading the old array, so it lives until the deque dies
+        m_retired.emplace_back(pArray);
+        m_array.store(pNew, std::memory_order_release);
+        return pNew;
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<int64_t> m_top = 0;
+    alignas(cache_line_size) std::atomic<int64_t> m_bottom = 0;
+    alignas(cache_line_size) std::atomic<array*> m_array;
+    std::vector<std::unique_ptr<array>> m_retired;
+};
+
+} // namespace Zest
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <initializer_list>
 #include <thread>
 #include <zest/time/timer.h>
 #include <zest/math/math.h>
@@ -19,25 +20,83 @@ namespace Profiler
 struct ProfileSettings
 {
     uint32_t MaxThreads = 120;
-    uint32_t MaxCallStack = 20;
+    uint32_t MaxCallStack = 50;
     uint32_t MaxEntriesPerThread = 100000;
     uint32_t MaxFrames = 10000;
     uint32_t MaxRegions = 10000;
+    uint32_t MaxCountersPerThread = 10000;
+    uint32_t MaxArgsPerThread = 100000;
 };
 
+// Interval statistics for a run of frames or regions
+struct PacingStats
+{
+    uint32_t intervals = 0;
+    int64_t period = 0;            // Target interval; the mean if no period was set
+    double meanInterval = 0.0;
+    double jitter = 0.0;           // Standard deviation of the interval
+    int64_t minInterval = 0;
+    int64_t maxInterval = 0;
+    int64_t maxDeviation = 0;      // Largest distance of an interval from the period
+    uint32_t missedDeadlines = 0;  // Intervals long enough to have skipped a slot
+    uint32_t overruns = 0;         // Spans which ran for longer than the period
+    int64_t histogramStart = 0;
+    int64_t histogramBucketSize = 1;
+    std::vector<uint32_t> histogram;
+    std::vector<int64_t> intervalTimes;
+};
+
+// A search match; duration is clipped to the end of the capture
+struct SearchResult
+{
+    uint32_t threadIndex = 0;
+    uint32_t entryIndex = 0;
+    int64_t duration = 0;
+};
+
+// Search indexing is spread over UI frames to stay interactive on large captures
+const uint32_t MaxEntriesIndexedPerFrame = 2000000;
+
 void SetProfileSettings(const ProfileSettings& settings);
 void Init();
 void UnDump(std::shared_ptr<ProfilerData>& profilerData);
+std::shared_ptr<ProfilerData> GetProfilerData();
 void NewFrame();
 void NameThread(const char* pszName);
 void SetPaused(bool pause);
+bool IsPaused();
 void BeginRegion();
 void EndRegion();
 void SetRegionLimit(uint64_t maxTimeNs);
-void PushSectionBase(const char*, uint32_t, const char*, int);
+void SetFramePeriod(uint64_t periodNs);
+void SetRegionPeriod(uint64_t periodNs);
+PacingStats AnalyzePacing(const std::vector<glm::i64vec2>& spans, int64_t periodNs, uint32_t histogramBuckets = 32);
+void PushSectionBase(const char*, uint32_t, const char*, int, std::initializer_list<ProfileArg> args = {});
 void PopSection();
+void Mark(const char*, uint32_t, const char*, int, std::initializer_list<ProfileArg> args = {});
+void Counter(const char* pszName, double value);
+std::string FormatArgs(const ThreadData& threadData, const ProfilerEntry& entry);
+void TrackAlloc(size_t size);
+void TrackFree(size_t size);
 void ShowProfile();
+void ShowPacing();
+void ShowAllocs();
+
+// The search box without the UI, over the capture being shown. Search indexes up to maxEntries more entries and
+// returns how many match the query by section or arg name. Steps go through the matches in start time order, from
+// the last one (or the middle of the view), and move the view to each
+uint64_t Search(const std::string& query, uint32_t maxEntries = MaxEntriesIndexedPerFrame);
+bool IsSearchIndexing();
+bool SearchStep(bool forward, SearchResult& result);
+std::vector<SearchResult> SearchSlowest(int count);
 void HideThread();
+
+// Automatic instrumentation; build with ZEST_PROFILE_INSTRUMENT and compile targets using zest_instrument_target().
+// With no filters every instrumented function is recorded; otherwise only those inside a filtered range
+void InstrumentAddressRange(uintptr_t begin, uintptr_t end);
+bool InstrumentModule(const char* pszModuleName);
+void InstrumentClearFilters();
+bool InstrumentFilterAccepts(uintptr_t address);
 void Finish();
 
 struct ProfileScope
@@ -46,6 +105,10 @@ struct ProfileScope
     {
         PushSectionBase(szSection, color, szFile, line);
     }
+    ProfileScope(const char* szSection, uint32_t color, const char* szFile, int line, std::initializer_list<ProfileArg> args)
+    {
+        PushSectionBase(szSection, color, szFile, line, args);
+    }
     ~ProfileScope()
     {
         PopSection();
@@ -102,14 +165,38 @@ const glm::vec4& ColorFromName(const char* pszName, const uint32_t len);
 static const uint32_t name##_color = Zest::ToPackedARGB(Zest::Profiler::ColorFromName(#name, uint32_t(strlen(#name)))); \
 Zest::Profiler::ProfileScope name##_scope(#name, name##_color, __FILE__, __LINE__);
 
+// PROFILE_SCOPE_ARGS(MyNameWithoutQuotes, {"batch", 512}, {"gain", 0.5f})
+// Args are integer or floating point values with static string names; they show in the tooltip
+#define PROFILE_SCOPE_ARGS(name, ...) \
+static const uint32_t name##_color = Zest::ToPackedARGB(Zest::Profiler::ColorFromName(#name, uint32_t(strlen(#name)))); \
+Zest::Profiler::ProfileScope name##_scope(#name, name##_color, __FILE__, __LINE__, { __VA_ARGS__ });
+
 // PROFILE_SCOPE(char*, ImColor32 bit value)
 #define PROFILE_SCOPE_STR(str, col) \
 Zest::Profiler::ProfileScope name##_scope(str, col, __FILE__, __LINE__);
 
+// An instant event: PROFILE_MARK(MyNameWithoutQuotes)
+#define PROFILE_MARK(name) \
+static const uint32_t name##_mark_color = Zest::ToPackedARGB(Zest::Profiler::ColorFromName(#name, uint32_t(strlen(#name)))); \
+Zest::Profiler::Mark(#name, name##_mark_color, __FILE__, __LINE__);
+
+// An instant event with args: PROFILE_MARK_ARGS(MyNameWithoutQuotes, {"frames", 12})
+#define PROFILE_MARK_ARGS(name, ...) \
+static const uint32_t name##_mark_color = Zest::ToPackedARGB(Zest::Profiler::ColorFromName(#name, uint32_t(strlen(#name)))); \
+Zest::Profiler::Mark(#name, name##_mark_color, __FILE__, __LINE__, { __VA_ARGS__ });
+
+// PROFILE_MARK(char*, ImColor32 bit value)
+#define PROFILE_MARK_STR(str, col) \
+Zest::Profiler::Mark(str, col, __FILE__, __LINE__);
+
 // Mark one extra region
 #define PROFILE_REGION(name) \
 Zest::Profiler::RegionScope name##_region;
 
+// Record a value on a counter track, e.g. PROFILE_COUNTER(Voices, voiceCount)
+#define PROFILE_COUNTER(name, value) \
+Zest::Profiler::Counter(#name, double(value));
+
 // Give a thread a name.
 #define PROFILE_NAME_THREAD(name) \
 Zest::Profiler::NameThread(#name);
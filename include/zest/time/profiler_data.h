@@ -1,5 +1,6 @@
 #pragma once
 
+#include <type_traits>
 #include <zest/file/serializer.h>
 namespace Zest
 {
@@ -7,6 +8,50 @@ namespace Zest
 namespace Profiler
 {
 
+enum EntryFlags : uint32_t
+{
+    EntryFlags_None = 0,
+    EntryFlags_Mark = (1 << 0) // An instant event; startTime == endTime
+};
+
+enum class ProfileArgType : uint32_t
+{
+    Int,
+    Float
+};
+
+// A named value attached to an entry, e.g. {"voices", 32}; the name must be a static string
+struct ProfileArg
+{
+    ProfileArg() = default;
+
+    template <typename T>
+    ProfileArg(const char* pszName, T value)
+        : szName(pszName)
+    {
+        static_assert(std::is_arithmetic_v<T>, "Profile args must be integer or floating point");
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            type = ProfileArgType::Float;
+            f = double(value);
+        }
+        else
+        {
+            type = ProfileArgType::Int;
+            i = int64_t(value);
+        }
+    }
+
+    const char* szName = nullptr;
+    uint64_t oldNamePointer;
+    ProfileArgType type = ProfileArgType::Int;
+    union
+    {
+        int64_t i = 0;
+        double f;
+    };
+};
+
 struct ProfilerEntry
 {
     // static infos
@@ -21,6 +66,25 @@ struct ProfilerEntry
     int64_t startTime;
     int64_t endTime;
     uint32_t parent;
+    uint32_t flags;
+    // args are stored in the thread's side buffer
+    uint32_t firstArg;
+    uint32_t argCount;
+    // allocation infos, attributed to the innermost scope (ZEST_PROFILE_MEMORY)
+    uint32_t allocCount;
+    uint32_t freeCount;
+    int64_t allocBytes;
+    int64_t freeBytes;
+    int64_t peakBytes;
+};
+
+// A timestamped value, displayed as a track over time
+struct CounterSample
+{
+    const char* szName = nullptr;
+    uint64_t oldNamePointer;
+    int64_t time;
+    double value;
 };
 
 struct FrameThreadInfo
@@ -46,6 +110,7 @@ struct ThreadData
 {
     bool initialized;
     uint32_t callStackDepth = 0;
+    uint32_t droppedDepth = 0; // Scopes pushed beyond MaxCallStack
     uint32_t maxLevel = 0;
     int64_t minTime;
     int64_t maxTime;
@@ -54,6 +119,10 @@ struct ThreadData
     std::string name;
     std::vector<ProfilerEntry> entries;
     std::vector<uint32_t> entryStack;
+    uint32_t currentCounter = 0;
+    std::vector<CounterSample> counters;
+    uint32_t currentArg = 0;
+    std::vector<ProfileArg> args;
 };
 
 // Everything needed to display a profile and capture relevent info
@@ -66,6 +135,9 @@ struct ProfilerData
     uint32_t currentFrame;
     uint32_t currentRegion;
     int64_t regionTimeLimit;
+    int64_t framePeriod = 0;  // Target frame interval for pacing analysis; 0 uses the mean
+    int64_t regionPeriod = 0; // Target region interval, e.g. the audio callback period
+    int64_t peakBytes = 0;
     std::vector<uint64_t> stringPointers;
     std::vector<std::string> strings;
 };
@@ -81,6 +153,14 @@ inline void serialize(binary_writer& w, const ProfilerEntry& t)
     serialize(w, t.startTime);
     serialize(w, t.endTime);
     serialize(w, t.parent);
+    serialize(w, t.flags);
+    serialize(w, t.firstArg);
+    serialize(w, t.argCount);
+    serialize(w, t.allocCount);
+    serialize(w, t.freeCount);
+    serialize(w, t.allocBytes);
+    serialize(w, t.freeBytes);
+    serialize(w, t.peakBytes);
 }
 
 inline void deserialize(binary_reader& r, ProfilerEntry& t)
@@ -94,6 +174,42 @@ inline void deserialize(binary_reader& r, ProfilerEntry& t)
     deserialize(r, t.startTime);
     deserialize(r, t.endTime);
     deserialize(r, t.parent);
+    deserialize(r, t.flags);
+    deserialize(r, t.firstArg);
+    deserialize(r, t.argCount);
+    deserialize(r, t.allocCount);
+    deserialize(r, t.freeCount);
+    deserialize(r, t.allocBytes);
+    deserialize(r, t.freeBytes);
+    deserialize(r, t.peakBytes);
+}
+
+inline void serialize(binary_writer& w, const ProfileArg& t)
+{
+    serialize(w, (uint64_t)t.szName);
+    serialize(w, t.type);
+    serialize(w, t.i);
+}
+
+inline void deserialize(binary_reader& r, ProfileArg& t)
+{
+    deserialize(r, t.oldNamePointer);
+    deserialize(r, t.type);
+    deserialize(r, t.i);
+}
+
+inline void serialize(binary_writer& w, const CounterSample& t)
+{
+    serialize(w, (uint64_t)t.szName);
+    serialize(w, t.time);
+    serialize(w, t.value);
+}
+
+inline void deserialize(binary_reader& r, CounterSample& t)
+{
+    deserialize(r, t.oldNamePointer);
+    deserialize(r, t.time);
+    deserialize(r, t.value);
 }
 
 inline void serialize(binary_writer& w, const ProfilerData& t)
@@ -105,6 +221,9 @@ inline void serialize(binary_writer& w, const ProfilerData& t)
     serialize(w, t.currentFrame);
     serialize(w, t.currentRegion);
     serialize(w, t.regionTimeLimit);
+    serialize(w, t.framePeriod);
+    serialize(w, t.regionPeriod);
+    serialize(w, t.peakBytes);
     serialize(w, t.stringPointers);
     serialize(w, t.strings);
 }
@@ -118,6 +237,9 @@ inline void deserialize(binary_reader& r, ProfilerData& t)
     deserialize(r, t.currentFrame);
     deserialize(r, t.currentRegion);
     deserialize(r, t.regionTimeLimit);
+    deserialize(r, t.framePeriod);
+    deserialize(r, t.regionPeriod);
+    deserialize(r, t.peakBytes);
     deserialize(r, t.stringPointers);
     deserialize(r, t.strings);
 
@@ -135,6 +257,10 @@ inline void serialize(binary_writer& w, const ThreadData& t)
     serialize(w, t.name);
     serialize(w, t.entries);
     serialize(w, t.entryStack);
+    serialize(w, t.currentCounter);
+    serialize(w, t.counters);
+    serialize(w, t.currentArg);
+    serialize(w, t.args);
 }
 
 inline void deserialize(binary_reader& r, ThreadData& t)
@@ -149,6 +275,10 @@ inline void deserialize(binary_reader& r, ThreadData& t)
     deserialize(r, t.name);
     deserialize(r, t.entries);
     deserialize(r, t.entryStack);
+    deserialize(r, t.currentCounter);
+    deserialize(r, t.counters);
+    deserialize(r, t.currentArg);
+    deserialize(r, t.args);
 }
 
 inline void serialize(binary_writer& w, const Region& t)
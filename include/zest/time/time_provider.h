@@ -12,6 +12,8 @@
 #include <zest/logger/logger.h>
 #include <zest/time/time_utils.h>
 #include <zest/time/profiler.h>
+#include <zest/thread/adaptive_mutex.h>
+#include <zest/thread/seqlock.h>
 #include <zest/thread/thread_utils.h>
 
 #include <moodycamel/concurrentqueue.h>
@@ -25,6 +27,15 @@ struct ITimeConsumer
     virtual void Tick() = 0;
 };
 
+// The last tick's time and beat, and the tempo to carry on from it; always read together
+struct TimeSnapshot
+{
+    TimePoint time;
+    double beat = 0.0;
+    double tempo = 120.0;
+    std::chrono::microseconds timePerBeat = std::chrono::microseconds(1000000 / 2);
+};
+
 class TimeProvider
 {
 public:
@@ -51,13 +62,14 @@ public:
     double GetTempo() const;
     double GetQuantum() const;
     std::chrono::microseconds GetTimePerBeat() const;
+    TimeSnapshot GetSnapshot() const;
 
-    double GetBeatAtTime(TimePoint time);
+    double GetBeatAtTime(TimePoint time) const;
 
 private:
     TimePoint m_startTime;
     std::unordered_set<ITimeConsumer*> m_consumers;
-    spin_mutex m_spin_mutex;
+    adaptive_mutex m_mutex;
 
     std::atomic_bool m_quitTimer = false;
     std::thread m_tickThread;
@@ -66,9 +78,8 @@ private:
     std::atomic<double> m_beat = 0;
     std::atomic<uint32_t> m_frame = 0;
 
-    TimePoint m_lastTime; // Should probably be atomic, but compile error on GCC?
-    std::atomic<double> m_lastBeat;
-    std::chrono::microseconds m_timePerBeat = std::chrono::microseconds(1000000 / 120);
+    // Written by the tick thread and SetTempo, read lock free from any thread
+    seqlock<TimeSnapshot> m_snapshot;
 };
 
 }; // namespace Zest
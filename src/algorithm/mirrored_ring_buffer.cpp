@@ -0,0 +1,126 @@
+#include <bit>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+#endif
+
+#include <zest/algorithm/mirrored_ring_buffer.h>
+
+namespace Zest
+{
+
+namespace
+{
+
+#ifdef __linux__
+// Two views of one memfd, side by side in a reserved range
+uint8_t* MapMirrored(size_t size)
+{
+    int fd = memfd_create("zest_ring", MFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    uint8_t* pData = nullptr;
+    if (ftruncate(fd, off_t(size)) == 0)
+    {
+        auto pRange = mmap(nullptr, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pRange != MAP_FAILED)
+        {
+            auto pBase = static_cast<uint8_t*>(pRange);
+            if (mmap(pBase, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+                mmap(pBase + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED)
+            {
+                pData = pBase;
+            }
+            else
+            {
+                munmap(pRange, size * 2);
+            }
+        }
+    }
+
+    // The mappings keep the pages alive
+    close(fd);
+    return pData;
+}
+#endif
+
+} // namespace
+
+size_t mirrored_memory_granularity()
+{
+#ifdef __linux__
+    static const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    return pageSize;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return size_t(info.dwAllocationGranularity);
+#else
+    return 4096;
+#endif
+}
+
+bool mirrored_memory_alloc(mirrored_memory& memory, size_t minSize)
+{
+    mirrored_memory_free(memory);
+
+    const auto size = std::bit_ceil(std::max(minSize, mirrored_memory_granularity()));
+
+#ifdef __linux__
+    memory.pData = MapMirrored(size);
+    if (memory.pData)
+    {
+        memory.size = size;
+        memory.mapped = true;
+        return true;
+    }
+#endif
+
+    // Fallback: two real copies, kept in step by the writer
+#ifdef _WIN32
+    memory.pData = static_cast<uint8_t*>(_aligned_malloc(size * 2, mirrored_memory_granularity()));
+#else
+    memory.pData = static_cast<uint8_t*>(std::aligned_alloc(mirrored_memory_granularity(), size * 2));
+#endif
+    if (!memory.pData)
+    {
+        return false;
+    }
+    memory.size = size;
+    memory.mapped = false;
+    return true;
+}
+
+void mirrored_memory_free(mirrored_memory& memory)
+{
+    if (!memory.pData)
+    {
+        return;
+    }
+
+    if (memory.mapped)
+    {
+#ifdef __linux__
+        munmap(memory.pData, memory.size * 2);
+#endif
+    }
+    else
+    {
+#ifdef _WIN32
+        _aligned_free(memory.pData);
+#else
+        std::free(memory.pData);
+#endif
+    }
+    memory = mirrored_memory{};
+}
+
+} // namespace Zest
@@ -0,0 +1,90 @@
+#include <catch.hpp>
+#include <numeric>
+#include <vector>
+
+#include <zest/algorithm/mirrored_ring_buffer.h>
+
+using namespace Zest;
+
+TEST_CASE("MirroredMemory", "Algorithm")
+{
+    mirrored_memory memory;
+    REQUIRE(mirrored_memory_alloc(memory, 100));
+    REQUIRE(memory.size == mirrored_memory_granularity());
+
+    // Both halves are the same bytes when mapped; the fallback leaves that to the writer
+    memory.pData[3] = 42;
+    if (memory.mapped)
+    {
+        REQUIRE(memory.pData[memory.size + 3] == 42);
+        memory.pData[memory.size + 5] = 7;
+        REQUIRE(memory.pData[5] == 7);
+    }
+
+    mirrored_memory_free(memory);
+    REQUIRE(memory.pData == nullptr);
+}
+
+TEST_CASE("MirroredRingBuffer", "Algorithm")
+{
+    mirrored_ring_buffer<int> buffer;
+    REQUIRE(mirrored_ring_buffer_init(buffer, 5));
+    REQUIRE(mirrored_ring_buffer_empty(buffer));
+
+    // Holds the newest capacity items, even though the storage is bigger
+    for (int i = 0; i < 7; i++)
+    {
+        mirrored_ring_buffer_add(buffer, i);
+    }
+    REQUIRE(mirrored_ring_buffer_size(buffer) == 5);
+    REQUIRE(mirrored_ring_buffer_drain(buffer) == 2);
+
+    std::vector<int> out;
+    mirrored_ring_buffer_assign_ordered(buffer, out, 4);
+    REQUIRE(out == std::vector<int>{ 3, 4, 5, 6 });
+    mirrored_ring_buffer_assign_ordered_newest(buffer, out, 2);
+    REQUIRE(out == std::vector<int>{ 5, 6 });
+
+    mirrored_ring_buffer_drain_n(buffer, 10);
+    REQUIRE(mirrored_ring_buffer_empty(buffer));
+}
+
+TEST_CASE("MirroredRingBufferWrap", "Algorithm")
+{
+    // Fill the whole storage, so runs wrap at the end
+    mirrored_ring_buffer<int> buffer;
+    REQUIRE(mirrored_ring_buffer_init(buffer, uint32_t(mirrored_memory_granularity() / sizeof(int))));
+    const auto capacity = size_t(buffer.capacity);
+
+    std::vector<int> in(capacity + capacity / 2);
+    std::iota(in.begin(), in.end(), 0);
+
+    // The first pass leaves the head half way; the second straddles the end of the storage
+    mirrored_ring_buffer_push_n(buffer, std::span<const int>(in).first(capacity / 2));
+    mirrored_ring_buffer_drain_n(buffer, uint32_t(capacity / 2));
+    mirrored_ring_buffer_push_n(buffer, std::span<const int>(in).subspan(capacity / 2, capacity));
+
+    // One span across the wrap, in order
+    auto view = mirrored_ring_buffer_view(buffer);
+    REQUIRE(view.size() == capacity);
+    for (size_t i = 0; i < view.size(); i++)
+    {
+        REQUIRE(view[i] == int(capacity / 2 + i));
+    }
+
+    auto newest = mirrored_ring_buffer_view_newest(buffer, 10);
+    REQUIRE(newest.size() == 10);
+    REQUIRE(newest[9] == int(capacity / 2 + capacity - 1));
+
+    // Too many drops the oldest
+    mirrored_ring_buffer_push_n(buffer, in);
+    REQUIRE(mirrored_ring_buffer_size(buffer) == capacity);
+    REQUIRE(mirrored_ring_buffer_view(buffer)[0] == int(in.size() - capacity));
+
+    std::vector<int> out(capacity / 4);
+    REQUIRE(mirrored_ring_buffer_peek_n(buffer, out, 2) == out.size());
+    REQUIRE(out[0] == int(in.size() - capacity + 2));
+    REQUIRE(mirrored_ring_buffer_pop_n(buffer, out) == out.size());
+    REQUIRE(out[0] == int(in.size() - capacity));
+    REQUIRE(mirrored_ring_buffer_size(buffer) == capacity - out.size());
+}
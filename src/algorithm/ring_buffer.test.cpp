@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+#include <zest/algorithm/ring_buffer.h>
+
+using namespace Zest;
+
+static_assert(std::ranges::random_access_range<ring_buffer<int>>);
+static_assert(std::ranges::random_access_range<const ring_buffer<int>>);
+
+TEST_CASE("RingBuffer", "Algorithm")
+{
+    ring_buffer<int> buffer;
+    ring_buffer_init(buffer, 5);
+    REQUIRE(buffer.data.size() == 8);
+    REQUIRE(ring_buffer_empty(buffer));
+
+    // Holds the newest capacity items, even though the storage is bigger
+    for (int i = 0; i < 7; i++)
+    {
+        ring_buffer_add(buffer, i);
+    }
+    REQUIRE(ring_buffer_size(buffer) == 5);
+    REQUIRE(ring_buffer_drain(buffer) == 2);
+
+    std::vector<int> out;
+    ring_buffer_assign_ordered(buffer, out, 4);
+    REQUIRE(out == std::vector<int>{ 3, 4, 5, 6 });
+    ring_buffer_assign_ordered_newest(buffer, out, 2);
+    REQUIRE(out == std::vector<int>{ 5, 6 });
+
+    ring_buffer_drain_n(buffer, 10);
+    REQUIRE(ring_buffer_empty(buffer));
+}
+
+TEST_CASE("RingBufferBulk", "Algorithm")
+{
+    ring_buffer<int> buffer;
+    ring_buffer_init(buffer, 8);
+
+    std::vector<int> in(20);
+    std::iota(in.begin(), in.end(), 0);
+
+    // Only the newest 8 survive
+    ring_buffer_push_n(buffer, in);
+    REQUIRE(ring_buffer_size(buffer) == 8);
+    REQUIRE(*buffer.begin() == 12);
+
+    std::vector<int> out(3);
+    REQUIRE(ring_buffer_pop_n(buffer, out) == 3);
+    REQUIRE(out == std::vector<int>{ 12, 13, 14 });
+
+    // Wraps the storage, so the view is in two parts
+    ring_buffer_push_n(buffer, std::span<const int>(in).subspan(0, 3));
+    auto view = ring_buffer_view(buffer);
+    REQUIRE(view.size() == 8);
+    REQUIRE(view.first.size() == 5);
+    REQUIRE(view.second.size() == 3);
+    REQUIRE(view.second[2] == 2);
+
+    std::vector<int> all(8);
+    REQUIRE(ring_buffer_peek_n(buffer, all) == 8);
+    REQUIRE(all == std::vector<int>{ 15, 16, 17, 18, 19, 0, 1, 2 });
+    REQUIRE(ring_buffer_peek_n(buffer, out, 6) == 2);
+    REQUIRE(out[1] == 2);
+
+    auto newest = ring_buffer_view_newest(buffer, 4);
+    REQUIRE(newest.size() == 4);
+    REQUIRE(newest.first[0] == 19);
+
+    // Iterators and ranges
+    REQUIRE(std::ranges::equal(buffer, all));
+    REQUIRE(buffer.end() - buffer.begin() == 8);
+    REQUIRE(buffer.begin()[5] == 0);
+    REQUIRE(*std::ranges::max_element(buffer) == 19);
+    ring_buffer<int>::const_iterator it = buffer.begin();
+    REQUIRE(*(it + 7) == 2);
+}
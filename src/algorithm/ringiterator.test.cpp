@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <catch.hpp>
+#include <deque>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+#include <zest/algorithm/ringiterator.h>
+
+using namespace Zest;
+
+static_assert(std::random_access_iterator<RingIterator<int>>);
+static_assert(std::random_access_iterator<ConstRingIterator<int>>);
+static_assert(std::random_access_iterator<RingIterator<int, std::deque<int>>>);
+static_assert(std::ranges::random_access_range<RingView<int>>);
+static_assert(std::ranges::sized_range<RingView<int>>);
+static_assert(std::ranges::view<RingView<int>>);
+
+TEST_CASE("RingIterator", "Algorithm")
+{
+    std::vector<int> data{ 0, 1, 2, 3, 4 };
+
+    RingIterator<int> it(data, size_t(3));
+    REQUIRE(*it == 3);
+    REQUIRE(*(it + 2) == 0);
+    REQUIRE(*(it - 4) == 4);
+    REQUIRE(it[7] == 0);
+
+    // Jumps don't move the iterator they start from, and wrap both ways
+    auto far = it + 1000003;
+    REQUIRE(*it == 3);
+    REQUIRE(*far == 1);
+    REQUIRE(far - it == 1000003);
+    REQUIRE(it - far == -1000003);
+    REQUIRE(it < far);
+    REQUIRE(std::distance(it, far) == 1000003);
+
+    // Going round once is a new position
+    auto lap = it;
+    for (int i = 0; i < 5; i++)
+    {
+        ++lap;
+    }
+    REQUIRE(*lap == *it);
+    REQUIRE(lap != it);
+    REQUIRE(--lap - it == 4);
+
+    ConstRingIterator<int> constIt = it;
+    REQUIRE(*constIt == 3);
+
+    auto inserted = RingIterator<int>(data, size_t(4)).insertAfter(5);
+    REQUIRE(*inserted == 5);
+    REQUIRE(data.back() == 5);
+}
+
+TEST_CASE("RingView", "Algorithm")
+{
+    // A window that wraps
+    std::vector<int> data{ 4, 9, 1, 8, 7, 2, 6 };
+    RingView window(data, 5, 5);
+    REQUIRE(window.size() == 5);
+    REQUIRE(std::ranges::equal(window, std::vector<int>{ 2, 6, 4, 9, 1 }));
+    REQUIRE(window[2] == 4);
+
+    std::ranges::sort(window);
+    REQUIRE(std::ranges::equal(window, std::vector<int>{ 1, 2, 4, 6, 9 }));
+    REQUIRE(data == std::vector<int>{ 4, 6, 9, 8, 7, 1, 2 });
+    REQUIRE(*std::ranges::lower_bound(window, 5) == 6);
+
+    auto [first, second] = window.segments();
+    REQUIRE(std::ranges::equal(first, std::vector<int>{ 1, 2 }));
+    REQUIRE(std::ranges::equal(second, std::vector<int>{ 4, 6, 9 }));
+
+    const std::vector<int>& constData = data;
+    RingView constWindow(constData, 5, 3);
+    static_assert(std::is_same_v<decltype(*constWindow.begin()), const int&>);
+    REQUIRE(std::ranges::equal(constWindow | std::views::reverse, std::vector<int>{ 4, 2, 1 }));
+}
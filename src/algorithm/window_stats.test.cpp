@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <array>
+#include <catch.hpp>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <zest/algorithm/window_stats.h>
+
+using namespace Zest;
+
+TEST_CASE("WindowStats", "Algorithm")
+{
+    window_stats<float> stats;
+    window_stats_init(stats, 64, 0.0, 100.0, 1000);
+    REQUIRE(window_stats_empty(stats));
+    REQUIRE(window_stats_mean(stats) == 0.0);
+
+    // Check every step against the whole window, as the rolling display used to do it
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> step(-5.0f, 5.0f);
+    std::vector<float> all;
+    float value = 50.0f;
+    for (int i = 0; i < 2000; i++)
+    {
+        value = std::clamp(value + step(random), 0.0f, 100.0f);
+        all.push_back(value);
+        window_stats_add(stats, value);
+
+        auto first = all.size() > 64 ? all.end() - 64 : all.begin();
+        std::vector<float> window(first, all.end());
+        REQUIRE(window_stats_size(stats) == window.size());
+        REQUIRE(window_stats_min(stats) == *std::min_element(window.begin(), window.end()));
+        REQUIRE(window_stats_max(stats) == *std::max_element(window.begin(), window.end()));
+
+        double mean = std::accumulate(window.begin(), window.end(), 0.0) / window.size();
+        REQUIRE(window_stats_mean(stats) == Approx(mean).epsilon(1e-9));
+        if (window.size() > 1)
+        {
+            double squares = 0.0;
+            for (auto sample : window)
+            {
+                squares += (sample - mean) * (sample - mean);
+            }
+            REQUIRE(window_stats_stddev(stats) == Approx(std::sqrt(squares / (window.size() - 1))).margin(1e-6));
+        }
+
+        // Within a bucket (0.1) of the exact rank
+        std::sort(window.begin(), window.end());
+        auto estimate = window_stats_percentile(stats, 0.5);
+        auto rankBelow = std::lower_bound(window.begin(), window.end(), float(estimate - 0.1)) - window.begin();
+        auto rankAbove = std::upper_bound(window.begin(), window.end(), float(estimate + 0.1)) - window.begin();
+        REQUIRE(rankBelow <= int64_t(window.size() / 2));
+        REQUIRE(rankAbove >= int64_t((window.size() - 1) / 2));
+        REQUIRE(window_stats_percentile(stats, 0.0) == Approx(window.front()).margin(0.1));
+        REQUIRE(window_stats_percentile(stats, 1.0) == window.back());
+    }
+}
+
+TEST_CASE("WindowStatsPushN", "Algorithm")
+{
+    // A batch matches adding one at a time, straight from a vector or array
+    std::vector<int> values{ 5, 1, 9, 3, 7, 2 };
+    window_stats<int> batch;
+    window_stats<int> single;
+    window_stats_init(batch, 4, 0.0, 10.0, 10);
+    window_stats_init(single, 4, 0.0, 10.0, 10);
+
+    window_stats_push_n(batch, values);
+    for (auto value : values)
+    {
+        window_stats_add(single, value);
+    }
+    REQUIRE(window_stats_size(batch) == 4);
+    REQUIRE(window_stats_min(batch) == window_stats_min(single));
+    REQUIRE(window_stats_max(batch) == 9);
+    REQUIRE(window_stats_mean(batch) == window_stats_mean(single));
+    REQUIRE(window_stats_percentile(batch, 0.5) == window_stats_percentile(single, 0.5));
+
+    const std::array<int, 3> more{ 8, 8, 8 };
+    window_stats_push_n(batch, more);
+    REQUIRE(window_stats_min(batch) == 2);
+    REQUIRE(window_stats_mean(batch) == Approx(6.5));
+}
+
+TEST_CASE("WindowStatsLarge", "Algorithm")
+{
+    // A million samples; the window slides without rescanning
+    const uint32_t capacity = 1 << 20;
+    window_stats<double> stats;
+    window_stats_init(stats, capacity, 0.0, 1.0);
+
+    for (uint32_t i = 0; i < capacity * 2; i++)
+    {
+        // Rising, so the max is always the newest and the min the oldest
+        window_stats_add(stats, double(i) / (capacity * 2));
+    }
+    REQUIRE(window_stats_size(stats) == capacity);
+    REQUIRE(window_stats_min(stats) == 0.5);
+    REQUIRE(window_stats_max(stats) == double(capacity * 2 - 1) / (capacity * 2));
+    REQUIRE(window_stats_mean(stats) == Approx(0.75).epsilon(1e-6));
+    REQUIRE(window_stats_percentile(stats, 0.5) == Approx(0.75).margin(1.0 / 256));
+
+    // Uniform over a quarter; stddev is width / sqrt(12)
+    REQUIRE(window_stats_stddev(stats) == Approx(0.5 / std::sqrt(12.0)).epsilon(1e-4));
+}
@@ -0,0 +1,180 @@
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include <zest/memory/memory.h>
+#include <zest/thread/thread_utils.h>
+
+using namespace Zest;
+
+namespace
+{
+
+// Torn if the halves differ
+struct Frame
+{
+    uint64_t first = 0;
+    uint64_t values[15] = {};
+    uint64_t last = 0;
+};
+
+template <class Mem>
+void WriteFrame(Mem& buffer, uint64_t value)
+{
+    ProducerMemLock lock(buffer);
+    lock.Data().first = value;
+    for (auto& v : lock.Data().values)
+    {
+        v = value;
+    }
+    lock.Data().last = value;
+}
+
+} // namespace
+
+TEST_CASE("TripleBuffer", "Memory")
+{
+    triple_buffer<Frame> buffer;
+    {
+        ConsumerMemLock lock(buffer);
+        REQUIRE(lock.Version() == 0);
+        REQUIRE(lock.Data().first == 0);
+    }
+
+    // Every publish is seen straight away, and the latest one wins
+    WriteFrame(buffer, 1);
+    WriteFrame(buffer, 2);
+    REQUIRE(buffer.HasNewData());
+    {
+        ConsumerMemLock lock(buffer);
+        REQUIRE(lock.Data().first == 2);
+        REQUIRE(lock.Version() == 2);
+    }
+    REQUIRE(!buffer.HasNewData());
+    {
+        ConsumerMemLock lock(buffer);
+        REQUIRE(lock.Data().last == 2);
+    }
+
+    const uint64_t Frames = 100000;
+    std::thread producer([&]() {
+        for (uint64_t frame = 3; frame <= Frames; frame++)
+        {
+            WriteFrame(buffer, frame);
+        }
+    });
+
+    uint64_t seen = 0;
+    bool ok = true;
+    while (seen < Frames)
+    {
+        ConsumerMemLock lock(buffer);
+        auto& data = lock.Data();
+        ok = ok && data.first == data.last && data.values[7] == data.first && data.first >= seen && lock.Version() == data.first;
+        seen = data.first;
+    }
+    producer.join();
+    REQUIRE(ok);
+}
+
+TEST_CASE("SnapshotBuffer", "Memory")
+{
+    snapshot_buffer<Frame, 3> buffer;
+    REQUIRE(buffer.LatestVersion() == 0);
+
+    const uint64_t Frames = 20000;
+    std::atomic<bool> ok = true;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back([&]() {
+            uint64_t seen = 0;
+            while (seen < Frames)
+            {
+                ConsumerMemLock lock(buffer);
+                auto& data = lock.Data();
+                if (data.first != data.last || data.values[3] != data.first || data.first < seen || lock.Version() != data.first)
+                {
+                    ok = false;
+                }
+                seen = data.first;
+            }
+        });
+    }
+
+    for (uint64_t frame = 1; frame <= Frames; frame++)
+    {
+        WriteFrame(buffer, frame);
+    }
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    REQUIRE(ok);
+    REQUIRE(buffer.LatestVersion() == Frames);
+}
+
+TEST_CASE("SnapshotBufferReaderLimit", "Memory")
+{
+    snapshot_buffer<Frame, 2> buffer;
+    WriteFrame(buffer, 1);
+
+    // Two held; a third has to wait, and the producer still has a free buffer to write
+    auto pFirst = buffer.TryGetConsumerMemory();
+    auto pSecond = buffer.TryGetConsumerMemory();
+    REQUIRE(pFirst);
+    REQUIRE(pSecond);
+    REQUIRE(buffer.TryGetConsumerMemory() == nullptr);
+
+    WriteFrame(buffer, 2);
+    WriteFrame(buffer, 3);
+    REQUIRE(pFirst->first == 1);
+    REQUIRE(pSecond->last == 1);
+
+    buffer.ReleaseConsumerMemory(*pFirst);
+    auto pThird = buffer.TryGetConsumerMemory();
+    REQUIRE(pThird);
+    REQUIRE(pThird->first == 3);
+    buffer.ReleaseConsumerMemory(*pSecond);
+    buffer.ReleaseConsumerMemory(*pThird);
+
+    // More reader threads than Readers take turns, and never see a torn frame
+    const uint64_t Frames = 20000;
+    std::atomic<bool> ok = true;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 6; r++)
+    {
+        readers.emplace_back([&]() {
+            uint64_t seen = 0;
+            while (seen < Frames)
+            {
+                ConsumerMemLock lock(buffer);
+                auto& data = lock.Data();
+                if (data.first != data.last || data.values[3] != data.first || data.first < seen)
+                {
+                    ok = false;
+                }
+                seen = data.first;
+            }
+        });
+    }
+
+    for (uint64_t frame = 4; frame <= Frames; frame++)
+    {
+        WriteFrame(buffer, frame);
+    }
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    REQUIRE(ok);
+}
+
+TEST_CASE("LockedDoubleBuffer", "Memory")
+{
+    PNL_CL_Memory<Frame, spin_mutex> buffer;
+    WriteFrame(buffer, 5);
+    ConsumerMemLock lock(buffer);
+    REQUIRE(lock.Data().first == 5);
+}
@@ -0,0 +1,89 @@
+#include <atomic>
+#include <catch.hpp>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/adaptive_mutex.h>
+
+using namespace Zest;
+
+TEST_CASE("AdaptiveMutex", "Thread")
+{
+    adaptive_mutex mutex;
+    REQUIRE(mutex.try_lock());
+    REQUIRE(!mutex.try_lock());
+    mutex.unlock();
+
+    // Enough threads to force parking on a small machine
+    int64_t total = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; i++)
+            {
+                std::lock_guard<adaptive_mutex> lock(mutex);
+                total++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(total == 80000);
+    REQUIRE(mutex.stats().acquisitions == 80001);
+
+    mutex.reset_stats();
+    REQUIRE(mutex.stats().acquisitions == 0);
+}
+
+TEST_CASE("AdaptiveSharedMutex", "Thread")
+{
+    adaptive_shared_mutex mutex;
+    REQUIRE(mutex.try_lock_shared());
+    REQUIRE(mutex.try_lock_shared());
+    REQUIRE(!mutex.try_lock());
+    mutex.unlock_shared();
+    mutex.unlock_shared();
+    REQUIRE(mutex.try_lock());
+    REQUIRE(!mutex.try_lock_shared());
+    mutex.unlock();
+
+    // Writers keep the two halves equal; readers must never see them differ
+    int64_t a = 0;
+    int64_t b = 0;
+    std::atomic<int> torn = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 5000; i++)
+            {
+                if (t % 4 == 0)
+                {
+                    std::lock_guard<adaptive_shared_mutex> lock(mutex);
+                    a++;
+                    b++;
+                }
+                else
+                {
+                    std::shared_lock<adaptive_shared_mutex> lock(mutex);
+                    if (a != b)
+                    {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(torn == 0);
+    REQUIRE(a == 10000);
+    REQUIRE(mutex.stats().acquisitions == 40000 + 3);
+}
@@ -0,0 +1,179 @@
+#include <array>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/broadcast_ring.h>
+
+using namespace Zest;
+
+TEST_CASE("BroadcastRing", "Thread")
+{
+    broadcast_ring<int, broadcast_overflow::Overwrite> ring(4, 2);
+    REQUIRE(ring.capacity() == 4);
+
+    auto space = ring.claim(3);
+    REQUIRE(space.size() == 3);
+    space.first[0] = 1;
+    space.first[1] = 2;
+    space.first[2] = 3;
+    REQUIRE(ring.poll(0).empty());
+    ring.publish();
+
+    // Both consumers see everything
+    auto items = ring.poll(0);
+    REQUIRE(items.size() == 3);
+    REQUIRE(items.first[2] == 3);
+    ring.release(0, 3);
+    REQUIRE(ring.poll(1, 2).size() == 2);
+
+    // Consumer 1 gets lapped and skips ahead
+    for (int i = 4; i <= 9; i++)
+    {
+        ring.push(i);
+    }
+    items = ring.poll(1);
+    REQUIRE(ring.lost(1) == 5);
+    REQUIRE(items.size() == 4);
+    REQUIRE(items.first[0] == 6);
+    REQUIRE(items.second.back() == 9);
+
+    // Consumer 0 reads its own copy, so the producer lapping it again doesn't change what it has
+    items = ring.poll(0);
+    REQUIRE(ring.lost(0) == 2);
+    REQUIRE(items.size() == 4);
+    ring.push(10);
+    REQUIRE(items.first[0] == 6);
+    ring.release(0, 1);
+    REQUIRE(ring.poll(0).first[0] == 7);
+}
+
+TEST_CASE("BroadcastRingOverflowPolicy", "Thread")
+{
+    // Items too big to copy atomically can only block; asking for Overwrite is a compile error
+    using Block = broadcast_ring<std::array<uint64_t, 4>>;
+    static_assert(!Block::overwritable);
+    static_assert(Block::overflow == broadcast_overflow::Block);
+
+    Block ring(2, 1);
+    ring.push({ 1, 2, 3, 4 });
+    REQUIRE(ring.poll(0).first[0][3] == 4);
+}
+
+TEST_CASE("BroadcastRingOverwriteThreads", "Thread")
+{
+    // The producer never waits; consumers see a gapless count except where they record a loss
+    const uint64_t Count = 200000;
+    broadcast_ring<uint64_t, broadcast_overflow::Overwrite> ring(16, 2, wait_strategy::BusySpin);
+
+    std::vector<int> ordered(2, 1);
+    std::vector<uint64_t> received(2, 0);
+    std::vector<std::thread> consumers;
+    for (size_t c = 0; c < 2; c++)
+    {
+        consumers.emplace_back([&, c]() {
+            uint64_t expected = 0;
+            uint64_t lost = 0;
+            for (;;)
+            {
+                auto items = ring.wait(c, 5);
+                if (items.empty())
+                {
+                    break;
+                }
+
+                expected += ring.lost(c) - lost;
+                lost = ring.lost(c);
+                for (auto span : { items.first, items.second })
+                {
+                    for (auto value : span)
+                    {
+                        ordered[c] = ordered[c] && value == expected++ ? 1 : 0;
+                    }
+                }
+                received[c] += items.size();
+                ring.release(c, items.size());
+            }
+        });
+    }
+
+    for (uint64_t value = 0; value < Count; value++)
+    {
+        ring.push(value);
+    }
+    ring.close();
+
+    for (auto& consumer : consumers)
+    {
+        consumer.join();
+    }
+    for (size_t c = 0; c < 2; c++)
+    {
+        REQUIRE(ordered[c] == 1);
+        REQUIRE(received[c] + ring.lost(c) == Count);
+    }
+}
+
+TEST_CASE("BroadcastRingThreads", "Thread")
+{
+    for (auto wait : { wait_strategy::BusySpin, wait_strategy::Yield, wait_strategy::Park })
+    {
+        const uint64_t Count = 20000;
+        broadcast_ring<uint64_t> ring(64, 3, wait);
+
+        std::vector<uint64_t> sums(3, 0);
+        std::vector<int> ordered(3, 1);
+        std::vector<std::thread> consumers;
+        for (size_t c = 0; c < 3; c++)
+        {
+            consumers.emplace_back([&, c]() {
+                uint64_t expected = 0;
+                for (;;)
+                {
+                    auto items = ring.wait(c, 7);
+                    if (items.empty())
+                    {
+                        break;
+                    }
+                    for (auto span : { items.first, items.second })
+                    {
+                        for (auto value : span)
+                        {
+                            ordered[c] = ordered[c] && value == expected++ ? 1 : 0;
+                            sums[c] += value;
+                        }
+                    }
+                    ring.release(c, items.size());
+                }
+            });
+        }
+
+        // Batches of 5, so claims straddle the wrap
+        for (uint64_t next = 0; next < Count; next += 5)
+        {
+            auto space = ring.claim(5);
+            uint64_t value = next;
+            for (auto& item : space.first)
+            {
+                item = value++;
+            }
+            for (auto& item : space.second)
+            {
+                item = value++;
+            }
+            ring.publish();
+        }
+        ring.close();
+
+        for (auto& consumer : consumers)
+        {
+            consumer.join();
+        }
+        for (size_t c = 0; c < 3; c++)
+        {
+            REQUIRE(ordered[c] == 1);
+            REQUIRE(sums[c] == Count * (Count - 1) / 2);
+            REQUIRE(ring.lost(c) == 0);
+        }
+    }
+}
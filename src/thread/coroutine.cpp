@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <array>
+#include <new>
+
+#include <zest/thread/coroutine.h>
+
+namespace Zest
+{
+
+namespace
+{
+
+// Frames are rounded up to a multiple of FrameGranularity; bigger ones go straight to the heap
+const size_t FrameGranularity = 64;
+const size_t FrameBuckets = 32;
+const size_t FrameBatch = 16;
+const size_t MaxCachedFrames = FrameBatch * 4;
+
+size_t FrameBucket(size_t size)
+{
+    return (size + FrameGranularity - 1) / FrameGranularity - 1;
+}
+
+struct FramePool
+{
+    spin_mutex mutex;
+    std::array<std::vector<void*>, FrameBuckets> frames;
+};
+
+// Never freed, as frames can be released by threads that outlive static destruction
+FramePool& GetFramePool()
+{
+    static auto pPool = new FramePool();
+    return *pPool;
+}
+
+struct FrameCache
+{
+    ~FrameCache()
+    {
+        auto& pool = GetFramePool();
+        spin_mutex_lock lock(pool.mutex);
+        for (size_t bucket = 0; bucket < FrameBuckets; bucket++)
+        {
+            pool.frames[bucket].insert(pool.frames[bucket].end(), frames[bucket].begin(), frames[bucket].end());
+        }
+    }
+
+    std::array<std::vector<void*>, FrameBuckets> frames;
+};
+thread_local FrameCache gFrameCacheTLS;
+
+// Heap order for timers, so the earliest deadline is at the front
+const auto Later = [](const auto& left, const auto& right) {
+    return left.time > right.time;
+};
+
+} // namespace
+
+namespace detail
+{
+
+void* coroutine_frame_alloc(size_t size)
+{
+    auto bucket = FrameBucket(size);
+    if (bucket >= FrameBuckets)
+    {
+        return ::operator new(size);
+    }
+
+    auto& cache = gFrameCacheTLS.frames[bucket];
+    if (cache.empty())
+    {
+        auto& pool = GetFramePool();
+        spin_mutex_lock lock(pool.mutex);
+        auto& shared = pool.frames[bucket];
+        auto count = std::min(shared.size(), FrameBatch);
+        cache.insert(cache.end(), shared.end() - count, shared.end());
+        shared.resize(shared.size() - count);
+    }
+
+    if (cache.empty())
+    {
+        return ::operator new((bucket + 1) * FrameGranularity);
+    }
+
+    auto p = cache.back();
+    cache.pop_back();
+    return p;
+}
+
+void coroutine_frame_free(void* p, size_t size) noexcept
+{
+    auto bucket = FrameBucket(size);
+    if (bucket >= FrameBuckets)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    // Frames are often freed on a different thread to the one that made them; pass the surplus on
+    auto& cache = gFrameCacheTLS.frames[bucket];
+    if (cache.capacity() == 0)
+    {
+        cache.reserve(MaxCachedFrames + 1);
+    }
+    cache.push_back(p);
+
+    if (cache.size() > MaxCachedFrames)
+    {
+        auto& pool = GetFramePool();
+        spin_mutex_lock lock(pool.mutex);
+        pool.frames[bucket].insert(pool.frames[bucket].end(), cache.end() - FrameBatch, cache.end());
+        cache.resize(cache.size() - FrameBatch);
+    }
+}
+
+} // namespace detail
+
+timer_queue::timer_queue(TPool* pPool)
+    : m_pPool(pPool)
+{
+    m_thread = std::thread([this]() {
+        run();
+    });
+    TimeProvider::Instance().RegisterConsumer(this);
+}
+
+timer_queue::~timer_queue()
+{
+    // Once this returns no tick is in progress, and none will call us again
+    TimeProvider::Instance().UnRegisterConsumer(this);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool timer_queue::is_ready(TimePoint time, double beat) const
+{
+    auto& provider = TimeProvider::Instance();
+    return time <= provider.Now() && beat <= provider.GetBeat();
+}
+
+void timer_queue::add(const waiter& w)
+{
+    bool earliest = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (w.time == TimePoint::min())
+        {
+            m_beats.push_back(w);
+        }
+        else
+        {
+            m_timers.push_back(w);
+            std::push_heap(m_timers.begin(), m_timers.end(), Later);
+            earliest = m_timers.front().handle == w.handle;
+        }
+    }
+
+    // The timer thread may be sleeping until a later deadline
+    if (earliest)
+    {
+        m_wake.notify_one();
+    }
+}
+
+size_t timer_queue::pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timers.size() + m_beats.size() + m_ready.size();
+}
+
+void timer_queue::resume(std::coroutine_handle<> handle)
+{
+    if (m_pPool)
+    {
+        m_pPool->submit([handle]() {
+            handle.resume();
+        });
+    }
+    else
+    {
+        handle.resume();
+    }
+}
+
+// Called on the time provider thread each beat, under the provider's lock; hands ready beat waiters to the timer thread
+void timer_queue::Tick()
+{
+    auto beat = TimeProvider::Instance().GetBeat();
+
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto itr = std::stable_partition(m_beats.begin(), m_beats.end(), [&](const waiter& w) {
+            return !(w.beat <= beat);
+        });
+        for (auto ready = itr; ready != m_beats.end(); ready++)
+        {
+            m_ready.push_back(ready->handle);
+        }
+        found = itr != m_beats.end();
+        m_beats.erase(itr, m_beats.end());
+    }
+
+    if (found)
+    {
+        m_wake.notify_one();
+    }
+}
+
+// The timer thread: sleeps until the earliest deadline or a tick's hand over, and resumes outside the lock,
+// since resumed coroutines may wait again
+void timer_queue::run()
+{
+    std::vector<std::coroutine_handle<>> due;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        const auto now = TimeProvider::Instance().Now();
+        while (!m_timers.empty() && m_timers.front().time <= now)
+        {
+            std::pop_heap(m_timers.begin(), m_timers.end(), Later);
+            due.push_back(m_timers.back().handle);
+            m_timers.pop_back();
+        }
+        due.insert(due.end(), m_ready.begin(), m_ready.end());
+        m_ready.clear();
+
+        if (!due.empty())
+        {
+            lock.unlock();
+            for (auto handle : due)
+            {
+                resume(handle);
+            }
+            due.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (m_timers.empty())
+        {
+            m_wake.wait(lock);
+        }
+        else
+        {
+            m_wake.wait_until(lock, m_timers.front().time);
+        }
+    }
+}
+
+} // namespace Zest
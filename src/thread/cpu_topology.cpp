@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <zest/file/file.h>
+#include <zest/string/string_utils.h>
+#include <zest/thread/cpu_topology.h>
+
+namespace Zest
+{
+
+namespace
+{
+
+// Single value files under /sys, or an empty string
+std::string ReadSysValue(const fs::path& path)
+{
+    if (!fs::exists(path))
+    {
+        return std::string();
+    }
+    return string_trim(file_read(path));
+}
+
+// Turn a set of keys into dense ids, in key order
+template <typename Key>
+uint32_t AssignDomainIds(const std::vector<Key>& keys, std::vector<uint32_t>& ids)
+{
+    std::map<Key, uint32_t> lookup;
+    for (auto& key : keys)
+    {
+        lookup.emplace(key, 0);
+    }
+
+    uint32_t next = 0;
+    for (auto& [key, id] : lookup)
+    {
+        id = next++;
+    }
+
+    ids.resize(keys.size());
+    for (size_t index = 0; index < keys.size(); index++)
+    {
+        ids[index] = lookup[keys[index]];
+    }
+    return next;
+}
+
+// Physical cores in id order, skipping the reserved ones at the end
+std::vector<uint32_t> AvailableCores(const CpuTopology& topology, uint32_t reservedCores)
+{
+    std::vector<uint32_t> cores;
+    auto count = topology.physicalCores > reservedCores ? topology.physicalCores - reservedCores : 0;
+    for (uint32_t core = 0; core < count; core++)
+    {
+        cores.push_back(core);
+    }
+    return cores;
+}
+
+} // namespace
+
+std::vector<uint32_t> CpuTopology::CoreCpus(uint32_t core) const
+{
+    std::vector<uint32_t> ret;
+    for (auto& cpu : cpus)
+    {
+        if (cpu.core == core)
+        {
+            ret.push_back(cpu.id);
+        }
+    }
+    return ret;
+}
+
+std::vector<uint32_t> CpuTopology::L3Cpus(uint32_t domain) const
+{
+    std::vector<uint32_t> ret;
+    for (auto& cpu : cpus)
+    {
+        if (cpu.l3Domain == domain)
+        {
+            ret.push_back(cpu.id);
+        }
+    }
+    return ret;
+}
+
+std::vector<uint32_t> CpuTopology::NumaCpus(uint32_t node) const
+{
+    std::vector<uint32_t> ret;
+    for (auto& cpu : cpus)
+    {
+        if (cpu.numaNode == node)
+        {
+            ret.push_back(cpu.id);
+        }
+    }
+    return ret;
+}
+
+std::vector<uint32_t> cpu_list_parse(const std::string& list)
+{
+    std::vector<uint32_t> cpus;
+    for (auto& range : string_split(string_trim(list), ","))
+    {
+        auto dash = range.find('-');
+        try
+        {
+            auto first = uint32_t(std::stoul(range.substr(0, dash)));
+            auto last = dash == std::string::npos ? first : uint32_t(std::stoul(range.substr(dash + 1)));
+            for (auto cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (...)
+        {
+            // Malformed entry; skip it
+        }
+    }
+    return cpus;
+}
+
+CpuTopology cpu_topology_read(const std::string& sysRoot)
+{
+    CpuTopology topology;
+
+    const auto cpuRoot = fs::path(sysRoot) / "cpu";
+    auto online = cpu_list_parse(ReadSysValue(cpuRoot / "online"));
+
+    std::vector<std::pair<uint32_t, uint32_t>> coreKeys;
+    std::vector<std::string> l2Keys;
+    std::vector<std::string> l3Keys;
+    for (auto id : online)
+    {
+        const auto cpuPath = cpuRoot / ("cpu" + std::to_string(id));
+
+        CpuInfo info;
+        info.id = id;
+
+        auto package = ReadSysValue(cpuPath / "topology" / "physical_package_id");
+        auto core = ReadSysValue(cpuPath / "topology" / "core_id");
+        info.package = package.empty() ? 0 : uint32_t(std::stoul(package));
+        coreKeys.emplace_back(info.package, core.empty() ? id : uint32_t(std::stoul(core)));
+
+        // Cache domains are named by the CPUs that share them; a CPU with no info gets a domain to itself
+        std::string l2 = "cpu" + std::to_string(id);
+        std::string l3 = l2;
+        for (uint32_t index = 0; fs::exists(cpuPath / "cache" / ("index" + std::to_string(index))); index++)
+        {
+            auto cachePath = cpuPath / "cache" / ("index" + std::to_string(index));
+            if (ReadSysValue(cachePath / "type") == "Instruction")
+            {
+                continue;
+            }
+
+            auto level = ReadSysValue(cachePath / "level");
+            auto shared = ReadSysValue(cachePath / "shared_cpu_list");
+            if (level == "2")
+            {
+                l2 = shared;
+            }
+            else if (level == "3")
+            {
+                l3 = shared;
+            }
+        }
+        l2Keys.push_back(l2);
+        l3Keys.push_back(l3);
+
+        topology.cpus.push_back(info);
+    }
+
+    std::vector<uint32_t> ids;
+    topology.physicalCores = AssignDomainIds(coreKeys, ids);
+    for (size_t index = 0; index < topology.cpus.size(); index++)
+    {
+        topology.cpus[index].core = ids[index];
+    }
+
+    topology.l2Domains = AssignDomainIds(l2Keys, ids);
+    for (size_t index = 0; index < topology.cpus.size(); index++)
+    {
+        topology.cpus[index].l2Domain = ids[index];
+    }
+
+    topology.l3Domains = AssignDomainIds(l3Keys, ids);
+    for (size_t index = 0; index < topology.cpus.size(); index++)
+    {
+        topology.cpus[index].l3Domain = ids[index];
+    }
+
+    // NUMA nodes list their CPUs; machines without NUMA have a single node 0
+    std::set<uint32_t> nodes;
+    const auto nodeRoot = fs::path(sysRoot) / "node";
+    for (auto node : cpu_list_parse(ReadSysValue(nodeRoot / "online")))
+    {
+        for (auto id : cpu_list_parse(ReadSysValue(nodeRoot / ("node" + std::to_string(node)) / "cpulist")))
+        {
+            for (auto& cpu : topology.cpus)
+            {
+                if (cpu.id == id)
+                {
+                    cpu.numaNode = node;
+                    nodes.insert(node);
+                }
+            }
+        }
+    }
+    topology.numaNodes = std::max(uint32_t(nodes.size()), 1u);
+
+    return topology;
+}
+
+const CpuTopology& cpu_topology()
+{
+    static const CpuTopology topology = []() {
+#ifdef __linux__
+        auto topology = cpu_topology_read("/sys/devices/system");
+        if (!topology.cpus.empty())
+        {
+            return topology;
+        }
+#endif
+        CpuTopology fallback;
+        auto count = std::max(std::thread::hardware_concurrency(), 1u);
+        for (uint32_t id = 0; id < count; id++)
+        {
+            CpuInfo info;
+            info.id = id;
+            info.core = id;
+            info.l2Domain = id;
+            fallback.cpus.push_back(info);
+        }
+        fallback.physicalCores = count;
+        fallback.l2Domains = count;
+        fallback.l3Domains = 1;
+        fallback.numaNodes = 1;
+        return fallback;
+    }();
+    return topology;
+}
+
+std::vector<uint32_t> cpu_reserved_cpus(const CpuTopology& topology, uint32_t reservedCores)
+{
+    std::vector<uint32_t> cpus;
+    auto firstReserved = topology.physicalCores > reservedCores ? topology.physicalCores - reservedCores : 0;
+    for (auto& cpu : topology.cpus)
+    {
+        if (cpu.core >= firstReserved)
+        {
+            cpus.push_back(cpu.id);
+        }
+    }
+    return cpus;
+}
+
+std::vector<std::vector<uint32_t>> cpu_pin_plan(const CpuTopology& topology, CpuPinPolicy policy, size_t workerCount, uint32_t reservedCores, uint32_t domain)
+{
+    std::vector<std::vector<uint32_t>> plan(workerCount);
+    if (policy == CpuPinPolicy::None || topology.cpus.empty())
+    {
+        return plan;
+    }
+
+    auto cores = AvailableCores(topology, reservedCores);
+    if (cores.empty())
+    {
+        return plan;
+    }
+
+    auto isAvailable = [&](const CpuInfo& cpu) {
+        return std::find(cores.begin(), cores.end(), cpu.core) != cores.end();
+    };
+
+    switch (policy)
+    {
+    case CpuPinPolicy::PhysicalCores:
+    {
+        for (size_t worker = 0; worker < workerCount; worker++)
+        {
+            plan[worker] = topology.CoreCpus(cores[worker % cores.size()]);
+        }
+        break;
+    }
+    case CpuPinPolicy::LogicalCpus:
+    {
+        // Spread across cores before doubling up on SMT siblings
+        std::vector<uint32_t> order;
+        for (uint32_t sibling = 0; order.size() < topology.cpus.size(); sibling++)
+        {
+            bool any = false;
+            for (auto core : cores)
+            {
+                auto cpus = topology.CoreCpus(core);
+                if (sibling < cpus.size())
+                {
+                    order.push_back(cpus[sibling]);
+                    any = true;
+                }
+            }
+            if (!any)
+            {
+                break;
+            }
+        }
+
+        for (size_t worker = 0; worker < workerCount; worker++)
+        {
+            plan[worker] = { order[worker % order.size()] };
+        }
+        break;
+    }
+    case CpuPinPolicy::CacheDomain:
+    case CpuPinPolicy::NumaNode:
+    {
+        std::vector<uint32_t> cpus;
+        for (auto& cpu : topology.cpus)
+        {
+            auto cpuDomain = policy == CpuPinPolicy::CacheDomain ? cpu.l3Domain : cpu.numaNode;
+            if (cpuDomain == domain && isAvailable(cpu))
+            {
+                cpus.push_back(cpu.id);
+            }
+        }
+
+        for (auto& workerCpus : plan)
+        {
+            workerCpus = cpus;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return plan;
+}
+
+bool thread_pin_current(const std::vector<uint32_t>& cpus)
+{
+    if (cpus.empty())
+    {
+        return false;
+    }
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (auto cpu : cpus)
+    {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+        {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    // macOS only offers affinity hints
+    return false;
+#endif
+}
+
+void thread_set_current_name(const char* pszName)
+{
+#ifdef __linux__
+    // 15 characters and a terminator is the limit
+    char name[16];
+    strncpy(name, pszName, sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+    pthread_setname_np(pthread_self(), name);
+#elif defined(__APPLE__)
+    pthread_setname_np(pszName);
+#elif defined(_WIN32)
+    std::wstring name(pszName, pszName + strlen(pszName));
+    SetThreadDescription(GetCurrentThread(), name.c_str());
+#else
+    (void)pszName;
+#endif
+}
+
+} // namespace Zest
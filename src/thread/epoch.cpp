@@ -0,0 +1,279 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/epoch.h>
+#include <zest/thread/thread_utils.h>
+
+namespace Zest
+{
+namespace epoch
+{
+
+namespace
+{
+
+struct Retired
+{
+    void* p;
+    void (*deleter)(void*);
+    uint64_t epoch;
+};
+
+// One per thread that has used the epoch, reused after the thread exits; never freed, since a scan may be reading it
+struct ThreadRecord
+{
+    // (epoch << 1) | 1 while pinned, 0 otherwise. Written by the owner, read by threads moving the epoch on
+    alignas(cache_line_size) std::atomic<uint64_t> state = 0;
+    std::atomic<uint64_t> retired = 0;
+    std::atomic<uint64_t> freed = 0;
+    std::atomic<bool> inUse = true;
+    ThreadRecord* pNext = nullptr;
+
+    // Owner only
+    uint32_t nesting = 0;
+    std::vector<Retired> bag;
+    std::vector<Retired> expired; // Taken off bag or the orphans, to free
+};
+
+// Left behind by exited threads
+struct Orphans
+{
+    std::mutex mutex;
+    std::vector<Retired> items;
+    std::atomic<uint64_t> freed = 0;
+};
+
+std::atomic<uint64_t> gEpoch = 0;
+std::atomic<ThreadRecord*> gRecords = nullptr;
+
+Orphans& GetOrphans()
+{
+    // Outlives the thread local holders, which may add to it at exit
+    static auto pOrphans = new Orphans();
+    return *pOrphans;
+}
+
+ThreadRecord* AcquireRecord()
+{
+    for (auto pRecord = gRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+    {
+        bool inUse = false;
+        if (!pRecord->inUse.load(std::memory_order_relaxed) && pRecord->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+        {
+            return pRecord;
+        }
+    }
+
+    auto pRecord = new ThreadRecord();
+    pRecord->bag.reserve(BatchSize * 2);
+    pRecord->expired.reserve(BatchSize * 2);
+    pRecord->pNext = gRecords.load(std::memory_order_relaxed);
+    while (!gRecords.compare_exchange_weak(pRecord->pNext, pRecord, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    return pRecord;
+}
+
+// Move the epoch on if every pinned thread has seen the current one; returns the epoch as it now stands
+uint64_t TryAdvance()
+{
+    auto epoch = gEpoch.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto pRecord = gRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+    {
+        const auto state = pRecord->state.load(std::memory_order_acquire);
+        if ((state & 1) && (state >> 1) != epoch)
+        {
+            return epoch;
+        }
+    }
+
+    // Somebody else may have beaten us to it; either way it has moved on
+    if (gEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        return epoch + 1;
+    }
+    return epoch;
+}
+
+// Move the front of a list in retire order that is old enough onto expired
+void TakeExpired(std::vector<Retired>& items, uint64_t epoch, std::vector<Retired>& expired)
+{
+    size_t count = 0;
+    while (count < items.size() && epoch - items[count].epoch >= 2)
+    {
+        count++;
+    }
+    expired.insert(expired.end(), items.begin(), items.begin() + count);
+    items.erase(items.begin(), items.begin() + count);
+}
+
+// Deleters may retire more, so they only run once the lists they came from are consistent
+uint64_t FreeAll(std::vector<Retired>& expired)
+{
+    for (auto& item : expired)
+    {
+        item.deleter(item.p);
+    }
+    auto count = uint64_t(expired.size());
+    expired.clear();
+    return count;
+}
+
+// Set while this thread runs deleters; retires from inside them only append
+thread_local bool gCollectingTLS = false;
+
+void Collect(ThreadRecord& record)
+{
+    if (gCollectingTLS)
+    {
+        return;
+    }
+    gCollectingTLS = true;
+
+    const auto epoch = TryAdvance();
+    TakeExpired(record.bag, epoch, record.expired);
+    record.freed.fetch_add(FreeAll(record.expired), std::memory_order_relaxed);
+
+    // Never wait for the lock; somebody else is collecting them
+    auto& orphans = GetOrphans();
+    {
+        std::unique_lock<std::mutex> lock(orphans.mutex, std::try_to_lock);
+        if (lock.owns_lock())
+        {
+            TakeExpired(orphans.items, epoch, record.expired);
+        }
+    }
+    orphans.freed.fetch_add(FreeAll(record.expired), std::memory_order_relaxed);
+
+    gCollectingTLS = false;
+}
+
+// Registers on first use, and hands the record back when the thread exits
+struct RecordHolder
+{
+    ThreadRecord* pRecord = nullptr;
+
+    ~RecordHolder()
+    {
+        if (!pRecord)
+        {
+            return;
+        }
+
+        Collect(*pRecord);
+        if (!pRecord->bag.empty())
+        {
+            auto& orphans = GetOrphans();
+            std::lock_guard<std::mutex> lock(orphans.mutex);
+            orphans.items.insert(orphans.items.end(), pRecord->bag.begin(), pRecord->bag.end());
+            pRecord->bag.clear();
+        }
+
+        // Its counts stay with the record, for the stats
+        pRecord->state.store(0, std::memory_order_release);
+        pRecord->nesting = 0;
+        pRecord->inUse.store(false, std::memory_order_release);
+    }
+};
+
+thread_local RecordHolder gRecordTLS;
+
+ThreadRecord& LocalRecord()
+{
+    if (!gRecordTLS.pRecord)
+    {
+        gRecordTLS.pRecord = AcquireRecord();
+    }
+    return *gRecordTLS.pRecord;
+}
+
+} // namespace
+
+guard::guard()
+{
+    auto& record = LocalRecord();
+    if (record.nesting++ == 0)
+    {
+        // A full barrier, so a thread moving the epoch on either sees us pinned or we see what it unlinked
+        record.state.exchange((gEpoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_seq_cst);
+    }
+}
+
+guard::~guard()
+{
+    auto& record = *gRecordTLS.pRecord;
+    if (--record.nesting == 0)
+    {
+        record.state.store(0, std::memory_order_release);
+    }
+}
+
+bool is_pinned()
+{
+    return gRecordTLS.pRecord && gRecordTLS.pRecord->nesting > 0;
+}
+
+void register_thread()
+{
+    LocalRecord();
+}
+
+void retire(void* p, void (*deleter)(void*))
+{
+    auto& record = LocalRecord();
+
+    // Stamped after the unlink that made p unreachable
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    record.bag.push_back(Retired{ p, deleter, gEpoch.load(std::memory_order_acquire) });
+    record.retired.fetch_add(1, std::memory_order_relaxed);
+
+    if (record.bag.size() % BatchSize == 0)
+    {
+        Collect(record);
+    }
+}
+
+void collect()
+{
+    Collect(LocalRecord());
+}
+
+void flush()
+{
+    auto& record = LocalRecord();
+    for (;;)
+    {
+        Collect(record);
+        bool orphansLeft;
+        {
+            auto& orphans = GetOrphans();
+            std::lock_guard<std::mutex> lock(orphans.mutex);
+            orphansLeft = !orphans.items.empty();
+        }
+        if (record.bag.empty() && !orphansLeft)
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+stats get_stats()
+{
+    stats result;
+    result.epoch = gEpoch.load(std::memory_order_relaxed);
+    result.freed = GetOrphans().freed.load(std::memory_order_relaxed);
+    for (auto pRecord = gRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+    {
+        result.retired += pRecord->retired.load(std::memory_order_relaxed);
+        result.freed += pRecord->freed.load(std::memory_order_relaxed);
+        result.threads += pRecord->inUse.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    return result;
+}
+
+} // namespace epoch
+} // namespace Zest
@@ -0,0 +1,196 @@
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/epoch.h>
+
+using namespace Zest;
+
+namespace
+{
+
+std::atomic<int64_t> gLiveNodes = 0;
+
+// A version of some shared state; readers check it is still whole
+struct Node
+{
+    Node(uint64_t value)
+        : value(value)
+        , check(~value)
+    {
+        gLiveNodes++;
+    }
+
+    ~Node()
+    {
+        // A reader still using it would race with this write
+        check = 0;
+        gLiveNodes--;
+    }
+
+    uint64_t value;
+    uint64_t check;
+};
+
+// Retires its child when it goes, as a node in a lock free tree might
+struct Parent
+{
+    Parent()
+        : pChild(new Node(7))
+    {
+    }
+
+    ~Parent()
+    {
+        epoch::retire(pChild);
+    }
+
+    Node* pChild;
+};
+
+} // namespace
+
+TEST_CASE("EpochRetireFromDeleter", "Thread")
+{
+    epoch::flush();
+    const auto before = gLiveNodes.load();
+
+    // Enough to cross batch boundaries while deleters are running
+    for (int i = 0; i < 1000; i++)
+    {
+        epoch::retire(new Parent());
+    }
+    epoch::flush();
+
+    REQUIRE(gLiveNodes == before);
+    REQUIRE(epoch::get_stats().Pending() == 0);
+}
+
+TEST_CASE("Epoch", "Thread")
+{
+    epoch::flush();
+    const auto before = gLiveNodes.load();
+
+    REQUIRE(!epoch::is_pinned());
+    {
+        auto outer = epoch::pin();
+        auto inner = epoch::pin();
+        REQUIRE(epoch::is_pinned());
+    }
+    REQUIRE(!epoch::is_pinned());
+
+    // Another thread pinned holds the free back, however often we try
+    std::atomic<int> stage = 0;
+    std::thread reader([&]() {
+        auto guard = epoch::pin();
+        stage = 1;
+        while (stage.load() != 2)
+        {
+            std::this_thread::yield();
+        }
+    });
+    while (stage.load() != 1)
+    {
+        std::this_thread::yield();
+    }
+
+    epoch::retire(new Node(1));
+    for (int i = 0; i < 10; i++)
+    {
+        epoch::collect();
+    }
+    REQUIRE(gLiveNodes == before + 1);
+    REQUIRE(epoch::get_stats().Pending() >= 1);
+
+    stage = 2;
+    reader.join();
+    epoch::flush();
+    REQUIRE(gLiveNodes == before);
+}
+
+TEST_CASE("EpochThreads", "Thread")
+{
+    epoch::flush();
+    const auto before = gLiveNodes.load();
+
+    // Writers swap in new versions and retire the old; readers pin and read through whatever they find
+    std::atomic<Node*> shared = new Node(0);
+    std::atomic<bool> stop = false;
+    std::atomic<uint32_t> torn = 0;
+    const uint32_t Writes = 20000;
+
+    std::vector<std::thread> readers;
+    for (uint32_t reader = 0; reader < 4; reader++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop.load())
+            {
+                auto guard = epoch::pin();
+                auto pNode = shared.load(std::memory_order_acquire);
+                if (pNode->check != ~pNode->value)
+                {
+                    torn++;
+                }
+
+                // Nested pins, and some readers leaving mid run to exercise record reuse
+                {
+                    auto nested = epoch::pin();
+                    auto pAgain = shared.load(std::memory_order_acquire);
+                    if (pAgain->check != ~pAgain->value)
+                    {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (uint32_t writer = 0; writer < 2; writer++)
+    {
+        writers.emplace_back([&, writer]() {
+            for (uint32_t i = 1; i <= Writes; i++)
+            {
+                auto pOld = shared.exchange(new Node(i * 2 + writer), std::memory_order_acq_rel);
+                epoch::retire(pOld);
+            }
+        });
+    }
+
+    // Short lived threads come and go, retiring as they leave
+    std::vector<std::thread> visitors;
+    for (uint32_t visitor = 0; visitor < 8; visitor++)
+    {
+        visitors.emplace_back([&]() {
+            auto guard = epoch::pin();
+            auto pOld = shared.exchange(new Node(1), std::memory_order_acq_rel);
+            epoch::retire(pOld);
+        });
+    }
+
+    for (auto& thread : writers)
+    {
+        thread.join();
+    }
+    for (auto& thread : visitors)
+    {
+        thread.join();
+    }
+    stop = true;
+    for (auto& thread : readers)
+    {
+        thread.join();
+    }
+
+    REQUIRE(torn == 0);
+
+    // Everything retired is freed once nobody is pinned; only the current version is left
+    epoch::flush();
+    REQUIRE(gLiveNodes == before + 1);
+    delete shared.load();
+
+    auto stats = epoch::get_stats();
+    REQUIRE(stats.Pending() == 0);
+    REQUIRE(stats.epoch > 0);
+}
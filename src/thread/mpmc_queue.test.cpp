@@ -0,0 +1,151 @@
+#include <atomic>
+#include <catch.hpp>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/mpmc_queue.h>
+
+using namespace Zest;
+
+TEST_CASE("MpmcQueue", "Thread")
+{
+    mpmc_queue<int> queue;
+    REQUIRE(queue.capacity() == 0);
+
+    // One producer's items come out in order
+    auto producer = queue.make_producer_token();
+    for (int i = 0; i < 5; i++)
+    {
+        queue.enqueue(producer, i);
+    }
+    std::vector<int> in{ 5, 6, 7 };
+    queue.enqueue_bulk(producer, in.begin(), in.size());
+    REQUIRE(queue.size_approx() == 8);
+
+    auto consumer = queue.make_consumer_token();
+    int item = -1;
+    REQUIRE(queue.try_dequeue(consumer, item));
+    REQUIRE(item == 0);
+
+    // Uninstrumented queues carry no counters
+    static_assert(sizeof(mpmc_queue<int>) < sizeof(mpmc_queue<int, true>));
+    REQUIRE(queue.stats().enqueued == 0);
+
+    std::vector<int> out(10);
+    REQUIRE(queue.try_dequeue_bulk(consumer, out.begin(), out.size()) == 7);
+    REQUIRE(out[0] == 1);
+    REQUIRE(out[6] == 7);
+    REQUIRE(!queue.try_dequeue(item));
+    REQUIRE(!queue.wait_dequeue_for(item, std::chrono::milliseconds(1)));
+    REQUIRE(queue.wait_dequeue_bulk_for(out.begin(), out.size(), std::chrono::milliseconds(1)) == 0);
+
+    // Move only items
+    mpmc_queue<std::unique_ptr<int>> owners;
+    owners.enqueue(std::make_unique<int>(3));
+    std::unique_ptr<int> owner;
+    owners.wait_dequeue(owner);
+    REQUIRE(*owner == 3);
+}
+
+TEST_CASE("MpmcQueueBounded", "Thread")
+{
+    bounded_mpmc_queue<int, true> queue(4);
+    REQUIRE(queue.capacity() == 4);
+
+    std::vector<int> in{ 0, 1, 2, 3, 4, 5 };
+    REQUIRE(queue.try_enqueue_bulk(in.begin(), in.size()) == 4);
+    REQUIRE(!queue.try_enqueue(6));
+    REQUIRE(!queue.enqueue_for(6, std::chrono::milliseconds(1)));
+
+    // A blocked producer goes once there is room
+    std::atomic<bool> done = false;
+    std::thread producer([&]() {
+        queue.enqueue_bulk(in.begin() + 4, 2);
+        done = true;
+    });
+
+    int item = -1;
+    queue.wait_dequeue(item);
+    REQUIRE(item == 0);
+    queue.wait_dequeue(item);
+
+    producer.join();
+    REQUIRE(done);
+    REQUIRE(queue.size_approx() == 4);
+
+    std::vector<int> out(4);
+    REQUIRE(queue.wait_dequeue_bulk(out.begin(), out.size()) == 4);
+    REQUIRE(out == std::vector<int>{ 2, 3, 4, 5 });
+
+    auto stats = queue.stats();
+    REQUIRE(stats.enqueued == 6);
+    REQUIRE(stats.dequeued == 6);
+    REQUIRE(stats.Depth() == 0);
+    REQUIRE(stats.fullWaits >= 2);
+    REQUIRE(std::accumulate(stats.latency.begin(), stats.latency.end(), uint64_t(0)) == 6);
+    REQUIRE(stats.LatencyPercentileNs(0.5) > 0);
+}
+
+TEST_CASE("MpmcQueueThreads", "Thread")
+{
+    // Several of each side through a small bound, so producers are held back
+    bounded_mpmc_queue<uint32_t, true> queue(64);
+    const uint32_t Producers = 4;
+    const uint32_t Consumers = 3;
+    const uint32_t PerProducer = 20000;
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < Producers; p++)
+    {
+        threads.emplace_back([&, p]() {
+            auto token = queue.make_producer_token();
+            std::vector<uint32_t> block(7);
+            for (uint32_t next = 0; next < PerProducer;)
+            {
+                if (next % 3 == 0)
+                {
+                    queue.enqueue(token, p * PerProducer + next++);
+                    continue;
+                }
+                auto count = std::min<uint32_t>(uint32_t(block.size()), PerProducer - next);
+                std::iota(block.begin(), block.begin() + count, p * PerProducer + next);
+                queue.enqueue_bulk(token, block.begin(), count);
+                next += count;
+            }
+        });
+    }
+
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<uint32_t> received = 0;
+    for (uint32_t c = 0; c < Consumers; c++)
+    {
+        threads.emplace_back([&]() {
+            auto token = queue.make_consumer_token();
+            std::vector<uint32_t> block(5);
+            while (received.load() < Producers * PerProducer)
+            {
+                auto count = queue.wait_dequeue_bulk_for(token, block.begin(), block.size(), std::chrono::milliseconds(1));
+                for (size_t i = 0; i < count; i++)
+                {
+                    sum += block[i];
+                }
+                received += uint32_t(count);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const uint64_t total = uint64_t(Producers) * PerProducer;
+    REQUIRE(received == total);
+    REQUIRE(sum == total * (total - 1) / 2);
+
+    auto stats = queue.stats();
+    REQUIRE(stats.enqueued == total);
+    REQUIRE(stats.dequeued == total);
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <catch.hpp>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/seqlock.h>
+
+using namespace Zest;
+
+namespace
+{
+
+// Odd size, so the last word is partly used
+struct Snapshot
+{
+    double time = 0.0;
+    double beat = 0.0;
+    float tempo = 0.0f;
+    uint8_t flags = 0;
+};
+
+} // namespace
+
+TEST_CASE("Seqlock", "Thread")
+{
+    seqlock<Snapshot> lock(Snapshot{ 1.0, 2.0, 120.0f, 1 });
+    auto version = lock.version();
+    REQUIRE((version & 1) == 0);
+
+    auto value = lock.load();
+    REQUIRE(value.beat == 2.0);
+    REQUIRE(value.tempo == 120.0f);
+    REQUIRE(value.flags == 1);
+
+    lock.update([](auto& snapshot) {
+        snapshot.beat += 1.0;
+    });
+    REQUIRE(lock.version() == version + 2);
+    REQUIRE(lock.load().beat == 3.0);
+    REQUIRE(lock.load().time == 1.0);
+
+    Snapshot copy;
+    REQUIRE(lock.try_load(copy));
+    REQUIRE(copy.tempo == 120.0f);
+}
+
+TEST_CASE("SeqlockThreads", "Thread")
+{
+    // Every published snapshot is self consistent; readers must never see a mix of two
+    seqlock<Snapshot> lock;
+    std::atomic<bool> stop = false;
+    const uint32_t Writes = 50000;
+
+    std::vector<std::thread> writers;
+    for (uint32_t writer = 0; writer < 2; writer++)
+    {
+        writers.emplace_back([&, writer]() {
+            for (uint32_t i = 1; i <= Writes; i++)
+            {
+                auto step = double(i * 2 + writer);
+                if (i & 1)
+                {
+                    lock.store(Snapshot{ step, step * 2.0, float(i % 1000), uint8_t(i) });
+                }
+                else
+                {
+                    lock.update([&](auto& snapshot) {
+                        snapshot = Snapshot{ step, step * 2.0, float(i % 1000), uint8_t(i) };
+                    });
+                }
+            }
+        });
+    }
+
+    std::atomic<uint32_t> torn = 0;
+    std::atomic<uint64_t> reads = 0;
+    std::vector<std::thread> readers;
+    for (uint32_t reader = 0; reader < 3; reader++)
+    {
+        readers.emplace_back([&]() {
+            while (!stop.load())
+            {
+                auto value = lock.load();
+                auto i = uint32_t(value.time) / 2;
+                if (value.beat != value.time * 2.0 || value.tempo != float(i % 1000) || value.flags != uint8_t(i))
+                {
+                    torn++;
+                }
+                reads++;
+            }
+        });
+    }
+
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+    stop = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    REQUIRE(torn == 0);
+    REQUIRE(reads > 0);
+    REQUIRE(lock.version() == uint64_t(Writes) * 2 * 2);
+}
@@ -0,0 +1,83 @@
+#include <catch.hpp>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <zest/thread/spsc_ring_buffer.h>
+
+using namespace Zest;
+
+TEST_CASE("SpscRingBuffer", "Thread")
+{
+    spsc_ring_buffer<int> ring(5);
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.empty());
+
+    std::vector<int> in(10);
+    std::iota(in.begin(), in.end(), 0);
+    REQUIRE(ring.write(in) == 8);
+    REQUIRE(!ring.push(100));
+    REQUIRE(ring.size() == 8);
+
+    int item = -1;
+    REQUIRE(ring.pop(item));
+    REQUIRE(item == 0);
+
+    // Wraps, so the readable run comes back in two pieces
+    std::vector<int> out(3);
+    REQUIRE(ring.read(out) == 3);
+    REQUIRE(out == std::vector<int>{ 1, 2, 3 });
+    REQUIRE(ring.write(std::span<const int>(in).subspan(8)) == 2);
+
+    auto view = ring.read_prepare();
+    REQUIRE(view.size() == 6);
+    REQUIRE(view.first.size() == 4);
+    REQUIRE(view.second.size() == 2);
+    REQUIRE(view.first[0] == 4);
+    REQUIRE(view.second[1] == 9);
+    ring.read_commit(view.size());
+    REQUIRE(ring.empty());
+
+    // Writing in place
+    auto space = ring.write_prepare(2);
+    REQUIRE(space.size() == 2);
+    space.first[0] = 7;
+    ring.write_commit(1);
+    REQUIRE(ring.pop(item));
+    REQUIRE(item == 7);
+}
+
+TEST_CASE("SpscRingBufferThreads", "Thread")
+{
+    spsc_ring_buffer<uint32_t> ring(64);
+    const uint32_t Count = 200000;
+
+    std::thread producer([&]() {
+        uint32_t next = 0;
+        uint32_t block[13];
+        while (next < Count)
+        {
+            auto count = std::min<uint32_t>(13, Count - next);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                block[i] = next + i;
+            }
+            next += uint32_t(ring.write(std::span<const uint32_t>(block, count)));
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    uint32_t block[17];
+    while (expected < Count)
+    {
+        auto count = ring.read(block);
+        for (size_t i = 0; i < count; i++)
+        {
+            ordered = ordered && block[i] == expected++;
+        }
+    }
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(ring.empty());
+}
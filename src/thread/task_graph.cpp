@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <zest/math/math_utils.h>
+#include <zest/thread/task_graph.h>
+#include <zest/time/profiler.h>
+
+namespace Zest
+{
+
+namespace
+{
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const uint32_t CriticalPathColor = ToPackedARGB(glm::vec4(1.0f, 0.2f, 0.2f, 1.0f));
+
+} // namespace
+
+task_graph::task_graph(const char* pszName)
+    : m_pszName(pszName)
+{
+}
+
+task_graph::node_id task_graph::add(const char* pszName, Zest::job&& fn)
+{
+    assert(!m_pPool);
+
+    node newNode;
+    newNode.pszName = pszName;
+    newNode.color = ToPackedARGB(Profiler::ColorFromName(pszName, uint32_t(strlen(pszName))));
+    newNode.fn = std::move(fn);
+    m_nodes.push_back(std::move(newNode));
+    m_dirty = true;
+    return node_id(m_nodes.size() - 1);
+}
+
+void task_graph::precede(node_id before, node_id after)
+{
+    assert(!m_pPool);
+    assert(before < m_nodes.size() && after < m_nodes.size() && before != after);
+
+    m_nodes[before].successors.push_back(after);
+    m_nodes[after].predecessors.push_back(before);
+    m_dirty = true;
+}
+
+void task_graph::clear()
+{
+    assert(!m_pPool);
+
+    m_nodes.clear();
+    m_roots.clear();
+    m_order.clear();
+    m_criticalPath.clear();
+    m_criticalTime = 0;
+    m_dirty = true;
+}
+
+const char* task_graph::name(node_id id) const
+{
+    return m_nodes[id].pszName;
+}
+
+const task_graph::node_timing& task_graph::timing(node_id id) const
+{
+    return m_nodes[id].timing;
+}
+
+// Find the roots and a topological order; only redone when the graph changes
+void task_graph::prepare()
+{
+    if (!m_dirty)
+    {
+        return;
+    }
+
+    m_roots.clear();
+    m_order.clear();
+
+    std::vector<uint32_t> inputs(m_nodes.size());
+    for (node_id id = 0; id < m_nodes.size(); id++)
+    {
+        inputs[id] = uint32_t(m_nodes[id].predecessors.size());
+        if (inputs[id] == 0)
+        {
+            m_roots.push_back(id);
+            m_order.push_back(id);
+        }
+    }
+
+    for (size_t index = 0; index < m_order.size(); index++)
+    {
+        for (auto successor : m_nodes[m_order[index]].successors)
+        {
+            if (--inputs[successor] == 0)
+            {
+                m_order.push_back(successor);
+            }
+        }
+    }
+
+    // Anything left over is part of a cycle and would never run
+    assert(m_order.size() == m_nodes.size());
+    m_dirty = false;
+}
+
+void task_graph::run(TPool& pool)
+{
+    assert(!m_pPool);
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    PROFILE_SCOPE(TaskGraph_Run);
+
+    prepare();
+
+    for (auto& n : m_nodes)
+    {
+        n.remaining->store(uint32_t(n.predecessors.size()), std::memory_order_relaxed);
+    }
+
+    m_pPool = &pool;
+    m_failed = false;
+    m_error = nullptr;
+    m_pending.store(m_nodes.size(), std::memory_order_release);
+
+    for (auto root : m_roots)
+    {
+        pool.submit([this, root]() {
+            execute(root);
+        });
+    }
+
+    while (m_pending.load(std::memory_order_acquire) != 0)
+    {
+        if (!pool.try_run_one())
+        {
+            std::this_thread::yield();
+        }
+    }
+    m_pPool = nullptr;
+
+    update_critical_path();
+
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+void task_graph::execute(node_id id)
+{
+    while (true)
+    {
+        auto& n = m_nodes[id];
+
+        n.timing.startTime = NowNs();
+        if (!m_failed.load(std::memory_order_relaxed))
+        {
+            Profiler::ProfileScope scope(n.pszName, n.critical ? CriticalPathColor : n.color, __FILE__, __LINE__, { { "node", id } });
+            try
+            {
+                n.fn();
+            }
+            catch (...)
+            {
+                if (!m_failed.exchange(true))
+                {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+        n.timing.endTime = NowNs();
+
+        // Keep the first released successor on this worker; its inputs are likely still in cache
+        auto next = node_id(-1);
+        for (auto successor : n.successors)
+        {
+            if (m_nodes[successor].remaining->fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                if (next == node_id(-1))
+                {
+                    next = successor;
+                }
+                else
+                {
+                    m_pPool->submit([this, successor]() {
+                        execute(successor);
+                    });
+                }
+            }
+        }
+
+        // The graph may be gone once the last node is counted off, so nothing is touched after this
+        // unless there is a successor, which keeps the count above zero
+        m_pending.fetch_sub(1, std::memory_order_release);
+        if (next == node_id(-1))
+        {
+            return;
+        }
+        id = next;
+    }
+}
+
+// Longest chain of node durations through the graph
+void task_graph::update_critical_path()
+{
+    std::vector<int64_t> pathTime(m_nodes.size(), 0);
+    std::vector<node_id> pathPrevious(m_nodes.size(), node_id(-1));
+
+    node_id last = m_order.front();
+    for (auto id : m_order)
+    {
+        auto& n = m_nodes[id];
+        int64_t longest = 0;
+        for (auto predecessor : n.predecessors)
+        {
+            if (pathTime[predecessor] > longest)
+            {
+                longest = pathTime[predecessor];
+                pathPrevious[id] = predecessor;
+            }
+        }
+        pathTime[id] = longest + (n.timing.endTime - n.timing.startTime);
+        if (pathTime[id] > pathTime[last])
+        {
+            last = id;
+        }
+        n.critical = false;
+    }
+
+    m_criticalPath.clear();
+    for (auto id = last; id != node_id(-1); id = pathPrevious[id])
+    {
+        m_criticalPath.push_back(id);
+        m_nodes[id].critical = true;
+    }
+    std::reverse(m_criticalPath.begin(), m_criticalPath.end());
+    m_criticalTime = pathTime[last];
+
+    Profiler::Counter(m_pszName, double(m_criticalTime) / 1000000.0);
+}
+
+} // namespace Zest
@@ -0,0 +1,991 @@
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <format>
+#include <set>
+
+#include <imgui.h>
+
+#include <zest/thread/thread_utils.h>
+#include <zest/thread/threadpool.h>
+#include <zest/time/profiler.h>
+
+// A queued task; recycled through per thread caches rather than freed
+struct TPool::TaskNode
+{
+    Zest::job fn;
+    TaskNode* pNext = nullptr;
+    int64_t enqueueTime = 0;
+    uint32_t lane = 0;
+};
+
+namespace
+{
+
+using TaskNode = TPool::TaskNode;
+
+// Rounds of stealing attempts before an idle worker parks
+const uint32_t SpinRounds = 64;
+const uint32_t YieldRounds = 4;
+
+// Every Nth task a worker runs is looked for bottom up, so lower lanes always make progress
+const uint64_t StarvationInterval = 16;
+
+const size_t RealTimeLane = size_t(TPool::Lane::RealTime);
+
+// Nodes move between a thread's cache and the shared pool in batches of this size
+const size_t NodeBatch = 64;
+const size_t MaxCachedNodes = NodeBatch * 16;
+
+// The pool (and slot) the current thread works for, if any
+thread_local const TPool* gPoolTLS = nullptr;
+thread_local uint32_t gWorkerIndexTLS = 0;
+
+struct NodePool
+{
+    std::mutex mutex;
+    std::vector<TaskNode*> nodes;
+};
+
+// Never freed; worker threads may still return nodes after static destruction has started.
+// Nodes are allocated in blocks and only ever grow to the peak number of tasks in flight
+NodePool& GetNodePool()
+{
+    static auto pPool = new NodePool();
+    return *pPool;
+}
+
+struct NodeCache
+{
+    NodeCache()
+    {
+        nodes.reserve(MaxCachedNodes + 1);
+    }
+
+    ~NodeCache()
+    {
+        auto& pool = GetNodePool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.nodes.insert(pool.nodes.end(), nodes.begin(), nodes.end());
+    }
+
+    std::vector<TaskNode*> nodes;
+};
+thread_local NodeCache gNodeCacheTLS;
+
+TaskNode* AllocNode()
+{
+    auto& cache = gNodeCacheTLS.nodes;
+    if (cache.empty())
+    {
+        auto& pool = GetNodePool();
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            auto count = std::min(pool.nodes.size(), NodeBatch);
+            cache.insert(cache.end(), pool.nodes.end() - count, pool.nodes.end());
+            pool.nodes.resize(pool.nodes.size() - count);
+        }
+
+        if (cache.empty())
+        {
+            auto pBlock = new TaskNode[NodeBatch];
+            for (size_t index = 0; index < NodeBatch; index++)
+            {
+                cache.push_back(&pBlock[index]);
+            }
+        }
+    }
+
+    auto pNode = cache.back();
+    cache.pop_back();
+    return pNode;
+}
+
+void FreeNode(TaskNode* pNode)
+{
+    pNode->fn.reset();
+    pNode->pNext = nullptr;
+
+    // Workers free what other threads allocate, so hand surplus back to the shared pool
+    auto& cache = gNodeCacheTLS.nodes;
+    cache.push_back(pNode);
+    if (cache.size() > MaxCachedNodes)
+    {
+        auto& pool = GetNodePool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.nodes.insert(pool.nodes.end(), cache.end() - NodeBatch, cache.end());
+        cache.resize(cache.size() - NodeBatch);
+    }
+}
+
+uint64_t xorshift(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Telemetry windows shorter than this give jumpy rates
+const int64_t TelemetryWindowNs = 250000000;
+
+// For counters with a single writer; readers only need to see some recent value
+template <class T>
+void Bump(std::atomic<T>& value, T amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// LaneCounters::maxWait: the reset generation in the top bits, the wait below
+const int MaxWaitShift = 48;
+const uint64_t MaxWaitMask = (uint64_t(1) << MaxWaitShift) - 1;
+
+// Generations wrap; only whether one matches the current one matters
+uint64_t PackMaxWait(int64_t waitNs, uint64_t generation)
+{
+    return (generation << MaxWaitShift) | std::min(uint64_t(std::max(waitNs, int64_t(0))), MaxWaitMask);
+}
+
+uint64_t MaxWaitGeneration(uint64_t packed)
+{
+    return packed >> MaxWaitShift;
+}
+
+// Whether packed should replace current: a longer wait, or the first since a reset
+bool IsNewMaxWait(uint64_t packed, uint64_t current)
+{
+    return MaxWaitGeneration(packed) != MaxWaitGeneration(current) || packed > current;
+}
+
+// Profiler samples keep the name pointer, so counter names outlive the pool
+const char* InternName(const std::string& name)
+{
+    static auto pNames = new std::set<std::string>();
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    return pNames->insert(name).first->c_str();
+}
+
+} // namespace
+
+TPool::TPool(size_t threads_n)
+    : TPool(TPoolSettings{ threads_n, 0 })
+{
+}
+
+TPool::TPool(const TPoolSettings& settings)
+{
+    start(settings);
+}
+
+void TPool::start(const TPoolSettings& settings)
+{
+    // If not enough threads, the pool will just execute all tasks immediately
+    m_generalCount = settings.threads > 1 ? settings.threads : 0;
+    m_minThreads = m_generalCount;
+
+    // Elastic pools get a slot for every worker they might run, so the deques never move
+    m_elastic = settings.maxThreads > std::max(settings.threads, size_t(1));
+    if (m_elastic)
+    {
+        m_minThreads = std::max(settings.threads, size_t(1));
+        m_generalCount = settings.maxThreads;
+        m_growLatencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(settings.growLatency).count();
+        m_idleTimeout = settings.idleTimeout;
+    }
+
+    m_name = settings.name ? settings.name : "TPool";
+    m_startNs = NowNs();
+    m_counterNames = { InternName(m_name + " Queue Depth"),
+        InternName(m_name + " Enqueue/s"),
+        InternName(m_name + " Busy %"),
+        InternName(m_name + " Wait p95 (us)") };
+
+    const auto total = m_generalCount + settings.realTimeThreads;
+    const auto& topology = Zest::cpu_topology();
+    auto plan = Zest::cpu_pin_plan(topology, settings.pinPolicy, total, settings.reservedCores, settings.pinDomain);
+    m_reservedCpus = Zest::cpu_reserved_cpus(topology, settings.reservedCores);
+
+    m_workers.reserve(total);
+    for (size_t index = 0; index < total; index++)
+    {
+        auto pWorker = std::make_unique<Worker>();
+        pWorker->realTime = index >= m_generalCount;
+        pWorker->cpus = plan[index];
+        pWorker->rng = 0x9E3779B97F4A7C15ull * (index + 1);
+        m_workers.push_back(std::move(pWorker));
+    }
+
+    // Start the threads once every deque exists, since they steal from each other
+    m_active = m_minThreads;
+    for (uint32_t index = 0; index < uint32_t(m_workers.size()); index++)
+    {
+        if (index < m_minThreads || index >= m_generalCount)
+        {
+            launch(index);
+        }
+    }
+}
+
+TPool::~TPool()
+{
+    m_stop = true;
+
+    // Let a spawn in progress finish; none start after this
+    {
+        std::lock_guard<std::mutex> lock(m_spawnMutex);
+    }
+
+    for (auto pLot : { &m_generalLot, &m_realTimeLot })
+    {
+        pLot->epoch.fetch_add(1);
+        pLot->epoch.notify_all();
+    }
+
+    if (m_elastic)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+        }
+        m_parkCondition.notify_all();
+    }
+
+    // Retired workers have exited already, but still need joining
+    for (auto& pWorker : m_workers)
+    {
+        if (pWorker->thread.joinable())
+        {
+            pWorker->thread.join();
+        }
+    }
+}
+
+void TPool::launch(uint32_t index)
+{
+    m_workers[index]->running = true;
+    m_workers[index]->thread = std::thread([this, index]() {
+        worker_loop(index);
+    });
+}
+
+bool TPool::spawn_worker()
+{
+    std::lock_guard<std::mutex> lock(m_spawnMutex);
+    if (m_stop || m_active.load() >= m_generalCount)
+    {
+        return false;
+    }
+
+    for (uint32_t index = 0; index < uint32_t(m_generalCount); index++)
+    {
+        auto& pWorker = m_workers[index];
+        if (pWorker->running.load())
+        {
+            continue;
+        }
+
+        // A retired worker clears running as its last act, so this join is short
+        if (pWorker->thread.joinable())
+        {
+            pWorker->thread.join();
+        }
+        m_active.fetch_add(1);
+        launch(index);
+        return true;
+    }
+    return false;
+}
+
+void TPool::maybe_grow()
+{
+    // An idle worker will get to the backlog; otherwise add one, at most once per growLatency
+    if (m_stop || m_generalLot.sleepers.load() > 0 || m_active.load() >= m_generalCount)
+    {
+        return;
+    }
+
+    auto now = NowNs();
+    auto last = m_lastGrowNs.load(std::memory_order_relaxed);
+    if (now - last < m_growLatencyNs || !m_lastGrowNs.compare_exchange_strong(last, now))
+    {
+        return;
+    }
+    spawn_worker();
+}
+
+bool TPool::begin_blocking()
+{
+    auto pSelf = current_worker();
+    if (!m_elastic || !pSelf || pSelf->realTime)
+    {
+        return false;
+    }
+
+    // With nobody idle to pick up the slack, replace this worker while it waits
+    m_blocked.fetch_add(1);
+    if (m_generalLot.sleepers.load() == 0)
+    {
+        spawn_worker();
+    }
+    return true;
+}
+
+void TPool::end_blocking()
+{
+    // Any surplus retires through the idle timeout
+    m_blocked.fetch_sub(1);
+}
+
+TPool::Worker* TPool::current_worker() const
+{
+    return gPoolTLS == this ? m_workers[gWorkerIndexTLS].get() : nullptr;
+}
+
+void TPool::submit(Zest::job&& fn, Lane lane)
+{
+    // If nothing will service the lane, just run the task in the calling thread
+    if (lane == Lane::RealTime ? m_workers.empty() : m_generalCount == 0)
+    {
+        fn();
+        return;
+    }
+
+    auto pNode = AllocNode();
+    pNode->fn = std::move(fn);
+    pNode->lane = uint32_t(lane);
+    pNode->enqueueTime = NowNs();
+    push_chain(pNode, pNode, 1, lane);
+}
+
+void TPool::submit_batch(std::span<Zest::job> tasks, Lane lane)
+{
+    if (lane == Lane::RealTime ? m_workers.empty() : m_generalCount == 0)
+    {
+        for (auto& fn : tasks)
+        {
+            fn();
+        }
+        return;
+    }
+
+    if (tasks.empty())
+    {
+        return;
+    }
+
+    // Chain the nodes up front so the injection queue takes them in one splice
+    TaskNode* pHead = nullptr;
+    TaskNode* pTail = nullptr;
+    auto now = NowNs();
+    for (auto& fn : tasks)
+    {
+        auto pNode = AllocNode();
+        pNode->fn = std::move(fn);
+        pNode->lane = uint32_t(lane);
+        pNode->enqueueTime = now;
+        if (pTail)
+        {
+            pTail->pNext = pNode;
+        }
+        else
+        {
+            pHead = pNode;
+        }
+        pTail = pNode;
+    }
+    push_chain(pHead, pTail, tasks.size(), lane);
+}
+
+void TPool::push_chain(TaskNode* pHead, TaskNode* pTail, size_t count, Lane lane)
+{
+    // Counted before the tasks can start, so the queue depth never goes negative
+    auto pWorker = current_worker();
+    if (pWorker)
+    {
+        Bump(pWorker->telemetry.enqueued, uint64_t(count));
+    }
+    else
+    {
+        m_externalTelemetry.enqueued.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // General workers keep their own submissions; real-time workers never hold anything else
+    if (lane != Lane::RealTime && pWorker && !pWorker->realTime)
+    {
+        for (auto pNode = pHead; pNode;)
+        {
+            auto pNext = pNode->pNext;
+            pNode->pNext = nullptr;
+            pWorker->tasks[size_t(lane)].push(pNode);
+            pNode = pNext;
+        }
+        wake(m_generalLot, count);
+        return;
+    }
+
+    // The tail may be run and recycled as soon as the lock is dropped
+    const auto now = pTail->enqueueTime;
+    int64_t oldest = 0;
+
+    auto& queue = m_inject[size_t(lane)];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.pHead)
+        {
+            oldest = queue.pHead->enqueueTime;
+        }
+
+        if (queue.pTail)
+        {
+            queue.pTail->pNext = pHead;
+        }
+        else
+        {
+            queue.pHead = pHead;
+        }
+        queue.pTail = pTail;
+        queue.count.fetch_add(count);
+    }
+
+    const bool realTimeWorkers = lane == Lane::RealTime && realtime_thread_count() > 0;
+    wake(realTimeWorkers ? m_realTimeLot : m_generalLot, count);
+
+    // Tasks already waiting too long, and nobody busy enough to run into them
+    if (m_elastic && !realTimeWorkers && oldest != 0 && now - oldest > m_growLatencyNs)
+    {
+        maybe_grow();
+    }
+}
+
+void TPool::wake(ParkingLot& lot, size_t count)
+{
+    // Pairs with the sleeper count increment in worker_loop; either the sleeper sees the new task
+    // on its final check, or we see the sleeper and bump the epoch it is waiting on.
+    // A deque push is only a release store, which may otherwise pass the sleeper load below
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (count == 0 || lot.sleepers.load() == 0)
+    {
+        return;
+    }
+
+    lot.epoch.fetch_add(1);
+    if (m_elastic && &lot == &m_generalLot)
+    {
+        // Taking the lock orders the epoch change against a sleeper's predicate check
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+        }
+
+        if (count == 1)
+        {
+            m_parkCondition.notify_one();
+        }
+        else
+        {
+            m_parkCondition.notify_all();
+        }
+        return;
+    }
+
+    if (count == 1)
+    {
+        lot.epoch.notify_one();
+    }
+    else
+    {
+        lot.epoch.notify_all();
+    }
+}
+
+TPool::TaskNode* TPool::pop_injected(size_t lane)
+{
+    auto& queue = m_inject[lane];
+    if (queue.count.load() == 0)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto pNode = queue.pHead;
+    if (!pNode)
+    {
+        return nullptr;
+    }
+
+    queue.pHead = pNode->pNext;
+    if (!queue.pHead)
+    {
+        queue.pTail = nullptr;
+    }
+    pNode->pNext = nullptr;
+    queue.count.fetch_sub(1);
+    return pNode;
+}
+
+TPool::TaskNode* TPool::steal(Worker* pSelf, size_t lane)
+{
+    thread_local uint64_t callerRng = 0x2545F4914F6CDD1Dull;
+    auto& rng = pSelf ? pSelf->rng : callerRng;
+
+    // Start at a random victim so thieves spread out; only general workers have deques in use
+    const auto count = m_generalCount;
+    const auto start = size_t(xorshift(rng) % count);
+    for (size_t offset = 0; offset < count; offset++)
+    {
+        auto& pVictim = m_workers[(start + offset) % count];
+        if (pVictim.get() == pSelf)
+        {
+            continue;
+        }
+
+        if (auto node = pVictim->tasks[lane].steal())
+        {
+            return *node;
+        }
+    }
+    return nullptr;
+}
+
+TPool::TaskNode* TPool::find_in_lane(Worker* pSelf, size_t lane)
+{
+    if (lane != RealTimeLane && pSelf)
+    {
+        if (auto node = pSelf->tasks[lane].pop())
+        {
+            return *node;
+        }
+    }
+
+    if (auto pNode = pop_injected(lane))
+    {
+        return pNode;
+    }
+
+    if (lane != RealTimeLane && m_generalCount > 0)
+    {
+        return steal(pSelf, lane);
+    }
+    return nullptr;
+}
+
+TPool::TaskNode* TPool::find_task(Worker* pSelf)
+{
+    if (pSelf && pSelf->realTime)
+    {
+        return pop_injected(RealTimeLane);
+    }
+
+    const bool bottomUp = pSelf && (pSelf->picks % StarvationInterval) == (StarvationInterval - 1);
+    for (size_t index = 0; index < LaneCount; index++)
+    {
+        auto lane = bottomUp ? (LaneCount - 1 - index) : index;
+        if (auto pNode = find_in_lane(pSelf, lane))
+        {
+            return pNode;
+        }
+    }
+    return nullptr;
+}
+
+void TPool::run(Worker* pSelf, TaskNode* pNode)
+{
+    const auto start = NowNs();
+    auto wait = start - pNode->enqueueTime;
+    if (m_elastic && wait > m_growLatencyNs && !(pSelf && pSelf->realTime))
+    {
+        maybe_grow();
+    }
+
+    const auto maxWait = PackMaxWait(wait, m_laneGeneration.load(std::memory_order_relaxed));
+    if (pSelf)
+    {
+        // Single writer
+        auto& counters = pSelf->laneCounters[pNode->lane];
+        counters.tasks.store(counters.tasks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counters.totalWaitNs.store(counters.totalWaitNs.load(std::memory_order_relaxed) + wait, std::memory_order_relaxed);
+        if (IsNewMaxWait(maxWait, counters.maxWait.load(std::memory_order_relaxed)))
+        {
+            counters.maxWait.store(maxWait, std::memory_order_relaxed);
+        }
+        pSelf->picks++;
+    }
+    else
+    {
+        auto& counters = m_externalCounters[pNode->lane];
+        counters.tasks.fetch_add(1, std::memory_order_relaxed);
+        counters.totalWaitNs.fetch_add(wait, std::memory_order_relaxed);
+        auto current = counters.maxWait.load(std::memory_order_relaxed);
+        while (IsNewMaxWait(maxWait, current) && !counters.maxWait.compare_exchange_weak(current, maxWait, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    auto& shard = pSelf ? pSelf->telemetry : m_externalTelemetry;
+    auto count = [&](auto& value, auto amount) {
+        if (pSelf)
+        {
+            Bump(value, amount);
+        }
+        else
+        {
+            value.fetch_add(amount, std::memory_order_relaxed);
+        }
+    };
+    count(shard.started, uint64_t(1));
+    count(shard.wait[Zest::latency_histogram_bucket(wait)], uint64_t(1));
+
+    pNode->fn();
+    FreeNode(pNode);
+
+    auto runNs = NowNs() - start;
+    count(shard.busyNs, runNs);
+    count(shard.runTime[Zest::latency_histogram_bucket(runNs)], uint64_t(1));
+}
+
+std::vector<uint32_t> TPool::free_cpus() const
+{
+    if (!m_reservedCpus.empty())
+    {
+        return m_reservedCpus;
+    }
+
+    std::vector<uint32_t> cpus;
+    for (auto& cpu : Zest::cpu_topology().cpus)
+    {
+        auto used = std::any_of(m_workers.begin(), m_workers.end(), [&](auto& pWorker) {
+            return pWorker->cpus.empty() || std::find(pWorker->cpus.begin(), pWorker->cpus.end(), cpu.id) != pWorker->cpus.end();
+        });
+        if (!used)
+        {
+            cpus.push_back(cpu.id);
+        }
+    }
+    return cpus;
+}
+
+bool TPool::pin_thread_away_from_workers() const
+{
+    return Zest::thread_pin_current(free_cpus());
+}
+
+bool TPool::try_run_one()
+{
+    if (m_workers.empty())
+    {
+        return false;
+    }
+
+    auto pSelf = current_worker();
+    if (auto pNode = find_task(pSelf))
+    {
+        run(pSelf, pNode);
+        return true;
+    }
+    return false;
+}
+
+TPool::LaneStats TPool::lane_stats(Lane lane) const
+{
+    std::lock_guard<std::mutex> lock(m_laneStatsMutex);
+    const auto generation = MaxWaitGeneration(PackMaxWait(0, m_laneGeneration.load(std::memory_order_relaxed)));
+
+    LaneStats stats;
+    auto add = [&](const LaneCounters& counters) {
+        stats.tasks += counters.tasks.load(std::memory_order_relaxed);
+        stats.totalWaitNs += counters.totalWaitNs.load(std::memory_order_relaxed);
+
+        // Maxima from before the last reset don't count
+        const auto maxWait = counters.maxWait.load(std::memory_order_relaxed);
+        if (MaxWaitGeneration(maxWait) == generation)
+        {
+            stats.maxWaitNs = std::max(stats.maxWaitNs, int64_t(maxWait & MaxWaitMask));
+        }
+    };
+
+    for (auto& pWorker : m_workers)
+    {
+        add(pWorker->laneCounters[size_t(lane)]);
+    }
+    add(m_externalCounters[size_t(lane)]);
+
+    auto& baseline = m_laneBaseline[size_t(lane)];
+    stats.tasks -= baseline.tasks;
+    stats.totalWaitNs -= baseline.totalWaitNs;
+    return stats;
+}
+
+void TPool::reset_lane_stats()
+{
+    std::lock_guard<std::mutex> lock(m_laneStatsMutex);
+    for (size_t lane = 0; lane < LaneCount; lane++)
+    {
+        auto& baseline = m_laneBaseline[lane];
+        baseline = LaneStats{};
+        for (auto& pWorker : m_workers)
+        {
+            baseline.tasks += pWorker->laneCounters[lane].tasks.load(std::memory_order_relaxed);
+            baseline.totalWaitNs += pWorker->laneCounters[lane].totalWaitNs.load(std::memory_order_relaxed);
+        }
+        baseline.tasks += m_externalCounters[lane].tasks.load(std::memory_order_relaxed);
+        baseline.totalWaitNs += m_externalCounters[lane].totalWaitNs.load(std::memory_order_relaxed);
+    }
+    m_laneGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+TPool::Telemetry TPool::Telemetry::Since(const Telemetry& earlier) const
+{
+    auto result = *this;
+    result.timeNs -= earlier.timeNs;
+    result.enqueued -= earlier.enqueued;
+    result.started -= earlier.started;
+    Zest::latency_histogram_subtract(result.waitHistogram, earlier.waitHistogram);
+    Zest::latency_histogram_subtract(result.runHistogram, earlier.runHistogram);
+    for (size_t index = 0; index < std::min(result.workers.size(), earlier.workers.size()); index++)
+    {
+        result.workers[index].tasks -= earlier.workers[index].tasks;
+        result.workers[index].busyNs -= earlier.workers[index].busyNs;
+    }
+    return result;
+}
+
+double TPool::Telemetry::EnqueueRate() const
+{
+    return timeNs > 0 ? double(enqueued) * 1e9 / double(timeNs) : 0.0;
+}
+
+double TPool::Telemetry::BusyFraction(size_t worker) const
+{
+    if (worker >= workers.size() || timeNs <= 0)
+    {
+        return 0.0;
+    }
+    return std::clamp(double(workers[worker].busyNs) / double(timeNs), 0.0, 1.0);
+}
+
+TPool::Telemetry TPool::telemetry() const
+{
+    Telemetry result;
+    result.timeNs = NowNs() - m_startNs;
+
+    auto add = [&](const TelemetryShard& shard) {
+        result.started += shard.started.load(std::memory_order_relaxed);
+        for (size_t bucket = 0; bucket < HistogramBuckets; bucket++)
+        {
+            result.waitHistogram[bucket] += shard.wait[bucket].load(std::memory_order_relaxed);
+            result.runHistogram[bucket] += shard.runTime[bucket].load(std::memory_order_relaxed);
+        }
+    };
+
+    // Every start follows its enqueue, so reading all the starts first keeps the depth from going negative
+    for (auto& pWorker : m_workers)
+    {
+        add(pWorker->telemetry);
+
+        WorkerTelemetry worker;
+        worker.tasks = pWorker->telemetry.started.load(std::memory_order_relaxed);
+        worker.busyNs = pWorker->telemetry.busyNs.load(std::memory_order_relaxed);
+        worker.realTime = pWorker->realTime;
+        worker.running = pWorker->running.load(std::memory_order_relaxed);
+        result.workers.push_back(worker);
+    }
+    add(m_externalTelemetry);
+
+    for (auto& pWorker : m_workers)
+    {
+        result.enqueued += pWorker->telemetry.enqueued.load(std::memory_order_relaxed);
+    }
+    result.enqueued += m_externalTelemetry.enqueued.load(std::memory_order_relaxed);
+
+    result.queueDepth = result.enqueued - result.started;
+    return result;
+}
+
+void TPool::update_telemetry()
+{
+    auto now = telemetry();
+    Zest::Profiler::Counter(m_counterNames[0], double(now.queueDepth));
+
+    Telemetry window;
+    {
+        std::lock_guard<std::mutex> lock(m_telemetryMutex);
+        if (now.timeNs - m_telemetryLast.timeNs < TelemetryWindowNs)
+        {
+            return;
+        }
+        m_telemetryWindow = now.Since(m_telemetryLast);
+        m_telemetryLast = now;
+        window = m_telemetryWindow;
+    }
+
+    double busy = 0.0;
+    size_t running = 0;
+    for (size_t index = 0; index < window.workers.size(); index++)
+    {
+        if (window.workers[index].running && !window.workers[index].realTime)
+        {
+            busy += window.BusyFraction(index);
+            running++;
+        }
+    }
+
+    Zest::Profiler::Counter(m_counterNames[1], window.EnqueueRate());
+    Zest::Profiler::Counter(m_counterNames[2], running ? busy * 100.0 / running : 0.0);
+    Zest::Profiler::Counter(m_counterNames[3], HistogramPercentileNs(window.waitHistogram, 0.95) / 1000.0);
+}
+
+void TPool::show_telemetry()
+{
+    Telemetry window;
+    {
+        std::lock_guard<std::mutex> lock(m_telemetryMutex);
+        window = m_telemetryWindow;
+    }
+
+    ImGui::PushID(this);
+    ImGui::Text("%s: %zu/%zu workers, %zu blocked", m_name.c_str(), active_thread_count(), thread_count(), blocked_thread_count());
+    ImGui::Text("Queued: %llu, enqueued: %.0f/s", (unsigned long long)telemetry().queueDepth, window.EnqueueRate());
+
+    auto showHistogram = [](const char* pszLabel, const Histogram& histogram) {
+        ImGui::Text("%s p50/p95/p99: %.1f/%.1f/%.1f us", pszLabel,
+            HistogramPercentileNs(histogram, 0.5) / 1000.0,
+            HistogramPercentileNs(histogram, 0.95) / 1000.0,
+            HistogramPercentileNs(histogram, 0.99) / 1000.0);
+
+        // Buckets double from 1us
+        std::array<float, HistogramBuckets> values;
+        size_t used = 1;
+        for (size_t bucket = 0; bucket < HistogramBuckets; bucket++)
+        {
+            values[bucket] = float(histogram[bucket]);
+            if (histogram[bucket])
+            {
+                used = bucket + 1;
+            }
+        }
+        ImGui::PlotHistogram(pszLabel, values.data(), int(used), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 40));
+    };
+    showHistogram("Wait", window.waitHistogram);
+    showHistogram("Run", window.runHistogram);
+
+    for (size_t index = 0; index < window.workers.size(); index++)
+    {
+        auto& worker = window.workers[index];
+        if (!worker.running)
+        {
+            continue;
+        }
+
+        auto fraction = window.BusyFraction(index);
+        auto label = std::format("{}{} {:.0f}% ({} tasks)", worker.realTime ? "RT " : "", index, fraction * 100.0, worker.tasks);
+        ImGui::ProgressBar(float(fraction), ImVec2(-1, 0), label.c_str());
+    }
+    ImGui::PopID();
+}
+
+void TPool::worker_loop(uint32_t index)
+{
+    gPoolTLS = this;
+    gWorkerIndexTLS = index;
+
+    auto pSelf = m_workers[index].get();
+    auto& lot = pSelf->realTime ? m_realTimeLot : m_generalLot;
+
+    auto name = pSelf->realTime ? std::format("{} RT {}", m_name, index - m_generalCount) : std::format("{} {}", m_name, index);
+    Zest::thread_set_current_name(name.c_str());
+    Zest::Profiler::NameThread(name.c_str());
+    Zest::thread_pin_current(pSelf->cpus);
+
+    while (true)
+    {
+        if (auto pNode = find_task(pSelf))
+        {
+            run(pSelf, pNode);
+            continue;
+        }
+
+        // Spin, then yield, before paying for a sleep and a wakeup
+        TaskNode* pFound = nullptr;
+        for (uint32_t round = 0; round < SpinRounds + YieldRounds && !pFound; round++)
+        {
+            if (round < SpinRounds)
+            {
+                cpu_relax();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+            pFound = find_task(pSelf);
+        }
+
+        if (pFound)
+        {
+            run(pSelf, pFound);
+            continue;
+        }
+
+        // Park. Announce first, then check once more so a concurrent submit can't be missed
+        auto epoch = lot.epoch.load();
+        lot.sleepers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (auto pNode = find_task(pSelf))
+        {
+            lot.sleepers.fetch_sub(1);
+            run(pSelf, pNode);
+            continue;
+        }
+
+        if (m_stop)
+        {
+            lot.sleepers.fetch_sub(1);
+            return;
+        }
+
+        if (!m_elastic || pSelf->realTime)
+        {
+            lot.epoch.wait(epoch);
+            lot.sleepers.fetch_sub(1);
+            continue;
+        }
+
+        if (park_timed(lot, epoch))
+        {
+            lot.sleepers.fetch_sub(1);
+            continue;
+        }
+
+        // Idle for the whole timeout. Stop counting as a sleeper before the last look, so a submit either
+        // wakes someone else or we see its task
+        lot.sleepers.fetch_sub(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (auto pNode = find_task(pSelf))
+        {
+            run(pSelf, pNode);
+            continue;
+        }
+
+        auto active = m_active.load();
+        while (active > m_minThreads)
+        {
+            if (m_active.compare_exchange_weak(active, active - 1))
+            {
+                // Our deques are empty; only we push to them
+                pSelf->running = false;
+                return;
+            }
+        }
+    }
+}
+
+bool TPool::park_timed(ParkingLot& lot, uint32_t epoch)
+{
+    std::unique_lock<std::mutex> lock(m_parkMutex);
+    return m_parkCondition.wait_for(lock, m_idleTimeout, [&]() {
+        return lot.epoch.load() != epoch;
+    });
+}
@@ -0,0 +1,566 @@
+#include <array>
+#include <atomic>
+#include <catch.hpp>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <zest/file/file.h>
+#include <zest/thread/coroutine.h>
+#include <zest/thread/cpu_topology.h>
+#include <zest/thread/parallel.h>
+#include <zest/thread/task_graph.h>
+#include <zest/thread/threadpool.h>
+#include <zest/thread/ws_deque.h>
+
+using namespace Zest;
+
+TEST_CASE("WorkStealingDeque", "Thread")
+{
+    ws_deque<int> deque(2);
+
+    // Grows past the initial capacity
+    for (int i = 0; i < 10; i++)
+    {
+        deque.push(i);
+    }
+    REQUIRE(deque.size() == 10);
+
+    // Owner pops newest, thieves take oldest
+    REQUIRE(deque.pop() == 9);
+    REQUIRE(deque.steal() == 0);
+    REQUIRE(deque.size() == 8);
+
+    while (deque.pop())
+    {
+    }
+    REQUIRE(deque.empty());
+    REQUIRE_FALSE(deque.steal());
+}
+
+TEST_CASE("ThreadPoolResults", "Thread")
+{
+    TPool pool(4);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 1000; i++)
+    {
+        results.push_back(pool.enqueue([](int value) { return value * 2; }, i));
+    }
+
+    int total = 0;
+    for (auto& result : results)
+    {
+        total += result.get();
+    }
+    REQUIRE(total == 999 * 1000);
+}
+
+TEST_CASE("ThreadPoolNestedSubmit", "Thread")
+{
+    std::atomic<int> count = 0;
+    {
+        TPool pool(4);
+        for (int i = 0; i < 100; i++)
+        {
+            (void)pool.enqueue([&]() {
+                for (int child = 0; child < 10; child++)
+                {
+                    (void)pool.enqueue([&]() { count++; });
+                }
+            });
+        }
+    }
+
+    // The destructor runs everything that was queued
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("ThreadPoolNestedWait", "Thread")
+{
+    // A worker submits to its own deque and blocks on the result; only another worker, woken from a
+    // sleep with no timeout, can run it. A lost wakeup hangs here
+    TPool pool(2);
+    REQUIRE_FALSE(pool.is_elastic());
+    for (int i = 0; i < 2000; i++)
+    {
+        auto outer = pool.enqueue([&pool]() {
+            return pool.enqueue([]() { return 1; }).get();
+        });
+        REQUIRE(outer.get() == 1);
+
+        // Now and then, let the other worker run out of spins and park
+        if (i % 64 == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+TEST_CASE("ThreadPoolSingleThreaded", "Thread")
+{
+    // One thread means no workers; tasks run inline
+    TPool pool(1);
+    REQUIRE(pool.thread_count() == 0);
+    auto result = pool.enqueue([]() { return 3; });
+    REQUIRE(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    REQUIRE(result.get() == 3);
+    REQUIRE_FALSE(pool.try_run_one());
+}
+
+TEST_CASE("JobSmallBuffer", "Thread")
+{
+    // Small captures live inline, large ones spill to the heap; both move and run
+    int value = 0;
+    job small([&value]() { value++; });
+    REQUIRE(small.is_inline());
+
+    std::array<char, job::InlineSize + 1> big{};
+    job large([&value, big]() { value += int(big.size()); });
+    REQUIRE_FALSE(large.is_inline());
+
+    job moved = std::move(small);
+    REQUIRE_FALSE(small);
+    moved();
+    large();
+    REQUIRE(value == 1 + int(job::InlineSize + 1));
+
+    // Move only captures are fine
+    auto pValue = std::make_unique<int>(5);
+    job owning([pValue = std::move(pValue), &value]() { value = *pValue; });
+    owning();
+    REQUIRE(value == 5);
+}
+
+TEST_CASE("ThreadPoolSubmit", "Thread")
+{
+    std::atomic<int> count = 0;
+    {
+        TPool pool(4);
+        for (int i = 0; i < 1000; i++)
+        {
+            pool.submit([&count]() { count++; });
+        }
+
+        std::vector<job> batch;
+        for (int i = 0; i < 1000; i++)
+        {
+            batch.emplace_back([&count]() { count++; });
+        }
+        pool.submit_batch(batch);
+    }
+    REQUIRE(count == 2000);
+}
+
+TEST_CASE("ParallelFor", "Thread")
+{
+    TPool pool(4);
+
+    std::vector<int> values(10000, 1);
+    parallel_for(pool, std::span(values), 0, [](int& value) { value *= 3; });
+    REQUIRE(std::accumulate(values.begin(), values.end(), 0) == 30000);
+
+    std::vector<std::atomic<int>> hits(1000);
+    parallel_for(pool, 0, 1000, 7, [&](int index) { hits[index]++; });
+    REQUIRE(std::all_of(hits.begin(), hits.end(), [](auto& hit) { return hit == 1; }));
+
+    // Empty ranges are a no-op
+    parallel_for(pool, 5, 5, 1, [](int) { REQUIRE(false); });
+}
+
+TEST_CASE("ParallelNested", "Thread")
+{
+    // Inner loops wait by running queued work, so nesting can't deadlock even with few workers
+    TPool pool(2);
+    std::atomic<int> count = 0;
+    parallel_for(pool, 0, 64, 1, [&](int) {
+        parallel_for(pool, 0, 64, 1, [&](int) { count++; });
+    });
+    REQUIRE(count == 64 * 64);
+}
+
+TEST_CASE("ParallelReduceTransform", "Thread")
+{
+    TPool pool(4);
+
+    auto sum = parallel_reduce(pool, 1, 10001, 100, int64_t(0), [](int index) { return int64_t(index); }, std::plus<int64_t>());
+    REQUIRE(sum == 50005000);
+
+    std::vector<float> in(1000);
+    std::iota(in.begin(), in.end(), 0.0f);
+    std::vector<float> out(in.size());
+    parallel_transform(pool, std::span<const float>(in), std::span(out), 0, [](float value) { return value * 2.0f; });
+    REQUIRE(out[999] == 1998.0f);
+
+    auto maxValue = parallel_reduce(pool, std::span(out), 16, 0.0f, [](float value) { return value; }, [](float a, float b) { return std::max(a, b); });
+    REQUIRE(maxValue == 1998.0f);
+
+    // bool partials sit apart; a packed vector<bool> would race here
+    auto anyOver = parallel_reduce(pool, 0, 4096, 1, false, [](int index) { return index == 4000; }, std::logical_or<bool>());
+    REQUIRE(anyOver);
+
+    // Failures in a chunk come back to the caller
+    REQUIRE_THROWS(parallel_for(pool, 0, 100, 1, [](int index) {
+        if (index == 50)
+        {
+            throw std::runtime_error("fail");
+        }
+    }));
+}
+
+TEST_CASE("TaskGraph", "Thread")
+{
+    TPool pool(4);
+    task_graph graph("TestGraph");
+
+    // Diamond: a -> (b, c) -> d, with b the slow side
+    std::atomic<int> order = 0;
+    int a = 0, b = 0, c = 0, d = 0;
+    auto nodeA = graph.add("A", [&]() { a = ++order; });
+    auto nodeB = graph.add("B", [&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        b = ++order;
+    });
+    auto nodeC = graph.add("C", [&]() { c = ++order; });
+    auto nodeD = graph.add("D", [&]() { d = ++order; });
+    graph.precede(nodeA, nodeB);
+    graph.precede(nodeA, nodeC);
+    graph.precede(nodeB, nodeD);
+    graph.precede(nodeC, nodeD);
+
+    // Runs repeatedly without being rebuilt
+    for (int run = 0; run < 3; run++)
+    {
+        order = 0;
+        graph.run(pool);
+        REQUIRE(a == 1);
+        REQUIRE(b > a);
+        REQUIRE(c > a);
+        REQUIRE(d == 4);
+    }
+
+    REQUIRE(graph.critical_path() == std::vector<task_graph::node_id>{ nodeA, nodeB, nodeD });
+    REQUIRE(graph.critical_path_time() >= 5000000);
+}
+
+namespace
+{
+
+task<int> PoolValue(TPool& pool, int value, int delayMs = 0)
+{
+    co_await schedule_on(pool);
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    co_return value;
+}
+
+task<int> PoolSum(TPool& pool)
+{
+    std::vector<task<int>> tasks;
+    for (int i = 0; i < 100; i++)
+    {
+        tasks.push_back(PoolValue(pool, i));
+    }
+
+    int total = 0;
+    for (auto value : co_await when_all(std::move(tasks)))
+    {
+        total += value;
+    }
+    co_return total;
+}
+
+task<void> PoolFail(TPool& pool)
+{
+    co_await schedule_on(pool);
+    throw std::runtime_error("fail");
+}
+
+// How long a sleep really took, in ms
+task<int64_t> TimedSleep(timer_queue& timers, int ms)
+{
+    auto start = std::chrono::steady_clock::now();
+    co_await timers.sleep_for(std::chrono::milliseconds(ms));
+    co_return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+TEST_CASE("Coroutines", "Thread")
+{
+    TPool pool(4);
+
+    REQUIRE(sync_wait(PoolSum(pool)) == 4950);
+    REQUIRE_THROWS(sync_wait(PoolFail(pool)));
+
+    std::vector<task<int>> race;
+    race.push_back(PoolValue(pool, 1, 100));
+    race.push_back(PoolValue(pool, 2));
+    auto first = sync_wait(when_any(std::move(race)));
+    REQUIRE(first.index == 1);
+    REQUIRE(first.value == 2);
+}
+
+TEST_CASE("CoroutineTimers", "Thread")
+{
+    // Sleeps end at their deadline, not on a later beat (half a second at the default tempo)
+    {
+        timer_queue timers;
+        auto ms = sync_wait(TimedSleep(timers, 20));
+        REQUIRE(ms >= 20);
+        REQUIRE(ms < 200);
+        REQUIRE(timers.pending() == 0);
+    }
+
+    // Several at once, on the pool; a later one doesn't hold back an earlier one
+    TPool pool(2);
+    timer_queue timers(&pool);
+    std::vector<task<int64_t>> sleeps;
+    sleeps.push_back(TimedSleep(timers, 150));
+    sleeps.push_back(TimedSleep(timers, 10));
+    sleeps.push_back(TimedSleep(timers, 40));
+
+    auto ms = sync_wait(when_all(std::move(sleeps)));
+    REQUIRE(ms[0] >= 150);
+    REQUIRE(ms[1] >= 10);
+    REQUIRE(ms[1] < 140);
+    REQUIRE(ms[2] >= 40);
+    REQUIRE(ms[2] < 140);
+}
+
+TEST_CASE("ThreadPoolLanes", "Thread")
+{
+    TPoolSettings settings;
+    settings.threads = 2;
+    settings.realTimeThreads = 1;
+    TPool pool(settings);
+    REQUIRE(pool.thread_count() == 2);
+    REQUIRE(pool.realtime_thread_count() == 1);
+
+    // Tie up the general workers; real-time work still gets through on its reserved worker
+    std::atomic<bool> release = false;
+    for (int i = 0; i < 2; i++)
+    {
+        pool.submit([&]() {
+            while (!release)
+            {
+                std::this_thread::yield();
+            }
+        }, TPool::Lane::Background);
+    }
+
+    // Normal lane, so this waits behind the blockers until release
+    auto normal = pool.enqueue([]() { return 1; });
+    std::atomic<int> realTimeDone = 0;
+    pool.submit([&]() { realTimeDone++; }, TPool::Lane::RealTime);
+    while (realTimeDone == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    std::atomic<int> count = 0;
+    std::vector<job> batch;
+    for (int i = 0; i < 100; i++)
+    {
+        batch.emplace_back([&]() { count++; });
+    }
+    pool.submit_batch(batch, TPool::Lane::High);
+
+    release = true;
+    REQUIRE(normal.get() == 1);
+    while (count != 100)
+    {
+        std::this_thread::yield();
+    }
+
+    REQUIRE(pool.lane_stats(TPool::Lane::RealTime).tasks == 1);
+    REQUIRE(pool.lane_stats(TPool::Lane::High).tasks == 100);
+    REQUIRE(pool.lane_stats(TPool::Lane::Background).tasks == 2);
+
+    pool.reset_lane_stats();
+    REQUIRE(pool.lane_stats(TPool::Lane::High).tasks == 0);
+    REQUIRE(pool.lane_stats(TPool::Lane::Background).maxWaitNs == 0);
+
+    // Counting carries on from the reset
+    pool.submit([]() {}, TPool::Lane::High);
+    while (pool.lane_stats(TPool::Lane::High).tasks == 0)
+    {
+        std::this_thread::yield();
+    }
+    REQUIRE(pool.lane_stats(TPool::Lane::High).tasks == 1);
+}
+
+TEST_CASE("CpuTopology", "Thread")
+{
+    REQUIRE(cpu_list_parse("0-3,8,10-11") == std::vector<uint32_t>{ 0, 1, 2, 3, 8, 10, 11 });
+    REQUIRE(cpu_list_parse("").empty());
+
+    // 2 packages x 2 cores x 2 SMT siblings; one L3 and one NUMA node per package
+    auto root = fs::temp_directory_path() / "zest_cpu_topology";
+    fs::remove_all(root);
+    auto write = [&](const fs::path& path, const std::string& value) {
+        fs::create_directories((root / path).parent_path());
+        file_write(root / path, value + "\n");
+    };
+    write("cpu/online", "0-7");
+    write("node/online", "0-1");
+    write("node/node0/cpulist", "0-3");
+    write("node/node1/cpulist", "4-7");
+    for (uint32_t id = 0; id < 8; id++)
+    {
+        auto cpu = fs::path("cpu") / ("cpu" + std::to_string(id));
+        uint32_t package = id / 4;
+        uint32_t core = (id / 2) % 2;
+        uint32_t first = package * 4 + core * 2;
+        write(cpu / "topology" / "physical_package_id", std::to_string(package));
+        write(cpu / "topology" / "core_id", std::to_string(core));
+        write(cpu / "cache" / "index0" / "type", "Data");
+        write(cpu / "cache" / "index0" / "level", "1");
+        write(cpu / "cache" / "index0" / "shared_cpu_list", std::to_string(first) + "-" + std::to_string(first + 1));
+        write(cpu / "cache" / "index1" / "type", "Unified");
+        write(cpu / "cache" / "index1" / "level", "2");
+        write(cpu / "cache" / "index1" / "shared_cpu_list", std::to_string(first) + "-" + std::to_string(first + 1));
+        write(cpu / "cache" / "index2" / "type", "Unified");
+        write(cpu / "cache" / "index2" / "level", "3");
+        write(cpu / "cache" / "index2" / "shared_cpu_list", std::to_string(package * 4) + "-" + std::to_string(package * 4 + 3));
+    }
+
+    auto topology = cpu_topology_read((root).string());
+    fs::remove_all(root);
+
+    REQUIRE(topology.cpus.size() == 8);
+    REQUIRE(topology.physicalCores == 4);
+    REQUIRE(topology.l2Domains == 4);
+    REQUIRE(topology.l3Domains == 2);
+    REQUIRE(topology.numaNodes == 2);
+    REQUIRE(topology.CoreCpus(topology.cpus[5].core) == std::vector<uint32_t>{ 4, 5 });
+    REQUIRE(topology.NumaCpus(1) == std::vector<uint32_t>{ 4, 5, 6, 7 });
+
+    auto plan = cpu_pin_plan(topology, CpuPinPolicy::PhysicalCores, 3, 1);
+    REQUIRE(plan.size() == 3);
+    REQUIRE(plan[0] == std::vector<uint32_t>{ 0, 1 });
+    REQUIRE(plan[2] == std::vector<uint32_t>{ 4, 5 });
+    REQUIRE(cpu_reserved_cpus(topology, 1) == std::vector<uint32_t>{ 6, 7 });
+
+    plan = cpu_pin_plan(topology, CpuPinPolicy::NumaNode, 2, 0, 1);
+    REQUIRE(plan[1] == std::vector<uint32_t>{ 4, 5, 6, 7 });
+
+    plan = cpu_pin_plan(topology, CpuPinPolicy::None, 2);
+    REQUIRE(plan[0].empty());
+}
+
+TEST_CASE("ThreadPoolPinning", "Thread")
+{
+    TPoolSettings settings;
+    settings.threads = 2;
+    settings.name = "PinTest";
+    settings.pinPolicy = CpuPinPolicy::LogicalCpus;
+    TPool pool(settings);
+
+    REQUIRE(pool.enqueue([]() { return 3; }).get() == 3);
+
+    // With one CPU per worker there may be nothing left over; either way the call mustn't pin to the workers
+    auto cpus = pool.free_cpus();
+    REQUIRE(pool.pin_thread_away_from_workers() == !cpus.empty());
+    thread_pin_current({});
+}
+
+TEST_CASE("ThreadPoolElastic", "Thread")
+{
+    TPoolSettings settings;
+    settings.threads = 1;
+    settings.maxThreads = 4;
+    settings.growLatency = std::chrono::microseconds(100);
+    settings.idleTimeout = std::chrono::milliseconds(20);
+    TPool pool(settings);
+
+    REQUIRE(pool.is_elastic());
+    REQUIRE(pool.thread_count() == 4);
+    REQUIRE(pool.active_thread_count() == 1);
+
+    // Every task blocks until all of them are running, which needs a worker each
+    std::atomic<int> started = 0;
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 4; i++)
+    {
+        results.push_back(pool.enqueue([&]() {
+            TPool::BlockingRegion blocking(pool);
+            started++;
+            while (started < 4)
+            {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    for (auto& result : results)
+    {
+        result.get();
+    }
+    REQUIRE(pool.blocked_thread_count() == 0);
+
+    // Back down to the minimum once idle
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (pool.active_thread_count() > 1 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(pool.active_thread_count() == 1);
+
+    // Retired slots can be used again
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        pool.submit([&]() { count++; });
+    }
+    while (count != 1000)
+    {
+        std::this_thread::yield();
+    }
+}
+
+TEST_CASE("ThreadPoolTelemetry", "Thread")
+{
+    TPool pool(2);
+
+    auto before = pool.telemetry();
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        pool.submit([&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            count++;
+        });
+    }
+    while (count != 100)
+    {
+        std::this_thread::yield();
+    }
+
+    // The last task counts its run time just after it finishes
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    TPool::Telemetry window;
+    do
+    {
+        window = pool.telemetry().Since(before);
+    } while (std::accumulate(window.runHistogram.begin(), window.runHistogram.end(), uint64_t(0)) < 100 && std::chrono::steady_clock::now() < deadline);
+
+    REQUIRE(window.enqueued == 100);
+    REQUIRE(window.started == 100);
+    REQUIRE(window.queueDepth == 0);
+    REQUIRE(std::accumulate(window.waitHistogram.begin(), window.waitHistogram.end(), uint64_t(0)) == 100);
+    REQUIRE(std::accumulate(window.runHistogram.begin(), window.runHistogram.end(), uint64_t(0)) == 100);
+    REQUIRE(TPool::HistogramPercentileNs(window.runHistogram, 0.5) >= 50000);
+    REQUIRE(window.workers.size() == 2);
+    REQUIRE(window.workers[0].tasks + window.workers[1].tasks == 100);
+    REQUIRE(window.BusyFraction(0) + window.BusyFraction(1) > 0.0);
+    REQUIRE(window.EnqueueRate() > 0.0);
+
+    TPool::Histogram histogram{};
+    histogram[0] = 90;
+    histogram[4] = 10;
+    REQUIRE(TPool::HistogramPercentileNs(histogram, 0.5) == TPool::HistogramLimitNs(0));
+    REQUIRE(TPool::HistogramPercentileNs(histogram, 0.99) == TPool::HistogramLimitNs(4));
+}
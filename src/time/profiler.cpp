@@ -1,8 +1,26 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
+#ifdef ZEST_PROFILE_MEMORY
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+
 #include <zest/math/imgui_glm.h>
 #include <zest/math/math_utils.h>
 #include <zest/string/murmur_hash.h>
@@ -36,6 +54,8 @@ using namespace Zest;
 // You have to pause to navigate/inspect.
 // All memory allocation is up-front; change the 'Max' values below to collect more frames
 // The profiler just 'stops' when the memory is full.  It can be restarted/stopped.
+// Build with ZEST_PROFILE_MEMORY to hook the global allocator; every allocation/free is attributed to the
+// innermost scope on the calling thread, and the live heap size is drawn as a counter track.
 // I pulled this together over the space of a weekend, it could be tidier here and there, but it works great ;)
 namespace Zest
 {
@@ -63,6 +83,8 @@ bool gPaused = true;
 bool gRequestPause = false;
 bool gRestarting = true;
 bool gHideUI = false;
+bool gShowPacing = false;
+bool gShowAllocs = false;
 
 std::mutex gMutex;
 
@@ -88,10 +110,90 @@ glm::i64vec2 gTimeRange = glm::i64vec2(0, 0);
 // Frames visible inside the current time range
 glm::ivec2 gVisibleFrames = glm::ivec2(0, 0);
 
-std::vector<glm::vec4> DefaultColors;
+// Allocation tracking
+const char* MemoryCounterName = "Memory";
+std::atomic<int64_t> gLiveBytes = 0;
+std::atomic<int64_t> gPeakBytes = 0;
+
+std::string FormatBytes(int64_t bytes)
+{
+    auto absBytes = std::abs(bytes);
+    if (absBytes < 1024)
+    {
+        return std::format("{}B", bytes);
+    }
+    else if (absBytes < 1024 * 1024)
+    {
+        return std::format("{:.2f}KB", bytes / 1024.0);
+    }
+    return std::format("{:.2f}MB", bytes / (1024.0 * 1024.0));
+}
+
+// Search index: for each thread, the entries written by each call site.
+// Entries are written in start order, so each site's list is sorted by index and by start time
+struct SearchSite
+{
+    const char* szSection = nullptr;
+    std::vector<const char*> argNames;
+    std::vector<uint32_t> entries;
+};
+
+struct SearchThreadIndex
+{
+    uint32_t indexedEntries = 0;
+    std::unordered_map<const char*, uint32_t> siteLookup;
+    std::vector<SearchSite> sites;
+    std::vector<uint32_t> matchedSites;
+};
+
+struct SearchState
+{
+    const ProfilerData* pData = nullptr;
+    uint64_t generation = 0;
+    std::vector<SearchThreadIndex> threads;
+    bool indexing = false;
+
+    std::string query;
+    std::string matchedQuery;
+    bool sitesChanged = false;
+    std::unordered_set<const char*> matchedSections;
+    uint64_t matchCount = 0;
+
+    bool hasCursor = false;
+    SearchResult cursor;
+
+    int slowestCount = 20;
+    std::vector<SearchResult> slowest;
+};
+SearchState gSearch;
 
 } // namespace
 
+// "batch=512 gain=0.5"
+std::string FormatArgs(const ThreadData& threadData, const ProfilerEntry& entry)
+{
+    std::string str;
+    for (uint32_t index = entry.firstArg; index < (entry.firstArg + entry.argCount) && index < threadData.args.size(); index++)
+    {
+        const auto& arg = threadData.args[index];
+        if (!str.empty())
+        {
+            str += " ";
+        }
+
+        auto szName = arg.szName ? arg.szName : "?";
+        if (arg.type == ProfileArgType::Float)
+        {
+            str += std::format("{}={}", szName, arg.f);
+        }
+        else
+        {
+            str += std::format("{}={}", szName, arg.i);
+        }
+    }
+    return str;
+}
+
 void Reset();
 
 // Optionally call this before doing any profiler calls to change the defaults
@@ -103,23 +205,27 @@ void SetProfileSettings(const ProfileSettings& s)
 
 #define NUM_DEFAULT_COLORS 16
 
-void CalculateColors()
+// Built on first use, so scope colors can be taken before Init (static scope colors, task graphs, tests)
+const std::vector<glm::vec4>& DefaultColors()
 {
-    double golden_ratio_conjugate = 0.618033988749895;
-    double h = .85f;
-    for (int i = 0; i < (int)NUM_DEFAULT_COLORS; i++)
-    {
-        h += golden_ratio_conjugate;
-        h = std::fmod(h, 1.0);
-        DefaultColors.emplace_back(HSVToRGB(float(h) * 360.0f, 0.6f, 200.0f));
-    }
+    static const std::vector<glm::vec4> colors = []() {
+        std::vector<glm::vec4> defaults;
+        double golden_ratio_conjugate = 0.618033988749895;
+        double h = .85f;
+        for (int i = 0; i < (int)NUM_DEFAULT_COLORS; i++)
+        {
+            h += golden_ratio_conjugate;
+            h = std::fmod(h, 1.0);
+            defaults.emplace_back(HSVToRGB(float(h) * 360.0f, 0.6f, 200.0f));
+        }
+        return defaults;
+    }();
+    return colors;
 }
 
 // Run Init every time a profile is started
 void Init()
 {
-    CalculateColors();
-
     gProfilerData = std::make_shared<ProfilerData>();
     gProfilerData->threadData.resize(settings.MaxThreads);
 
@@ -136,8 +242,13 @@ void Init()
         threadData->name = std::string("Thread ") + std::to_string(iZero);
         threadData->entries.resize(settings.MaxEntriesPerThread);
         memset(threadData->entries.data(), 0, sizeof(ProfilerEntry) * threadData->entries.size());
-        threadData->entryStack.resize(50);
+        threadData->entryStack.resize(settings.MaxCallStack);
         threadData->callStackDepth = 0;
+        threadData->droppedDepth = 0;
+        threadData->counters.resize(settings.MaxCountersPerThread);
+        threadData->currentCounter = 0;
+        threadData->args.resize(settings.MaxArgsPerThread);
+        threadData->currentArg = 0;
     }
 
     gProfilerData->frameData.resize(settings.MaxFrames);
@@ -159,6 +270,8 @@ void Init()
     gRestarting = true;
     gProfilerData->currentFrame = 0;
     gProfilerData->currentRegion = 0;
+    gProfilerData->peakBytes = 0;
+    gPeakBytes = gLiveBytes.load();
     gProfilerData->maxFrameTime = duration_cast<nanoseconds>(milliseconds(30)).count();
     gVisibleFrames = glm::uvec2(0, 0);
     gFrameCandleRange = glm::vec2(0, 0);
@@ -186,6 +299,11 @@ void UnDump(std::shared_ptr<ProfilerData>& data)
     gHideUI = false;
 }
 
+std::shared_ptr<ProfilerData> GetProfilerData()
+{
+    return gProfilerData;
+}
+
 void InitThread()
 {
     std::unique_lock<std::mutex> lk(gMutex);
@@ -199,6 +317,8 @@ void InitThread()
             gThreadIndexTLS = iThread;
             gGenerationTLS = gProfilerGeneration;
             threadData->currentEntry = 0;
+            threadData->currentCounter = 0;
+            threadData->currentArg = 0;
             threadData->initialized = true;
 
             return;
@@ -220,6 +340,11 @@ void Finish()
     gProfilerData->threadData.clear();
 }
 
+bool IsPaused()
+{
+    return gPaused;
+}
+
 void SetPaused(bool pause)
 {
     if (gPaused != pause)
@@ -291,30 +416,11 @@ bool CheckEndState()
     return gPaused;
 }
 
-void PushSectionBase(const char* szSection, unsigned int color, const char* szFile, int line)
+// Write the next entry for this thread, as a child of the current scope.
+// Args are copied into the thread's side buffer, so this never allocates
+ProfilerEntry* WriteEntry(ThreadData* threadData, const char* szSection, unsigned int color, const char* szFile, int line, std::initializer_list<ProfileArg> args)
 {
-    if (gPaused)
-    {
-        return;
-    }
-
-    ThreadData* threadData = GetThreadData();
-    if (CheckEndState())
-    {
-        return;
-    }
-
-    assert(threadData->callStackDepth < settings.MaxCallStack && "Might need to make call stack bigger!");
-
-    // check again
-    if (gPaused)
-    {
-        return;
-    }
-
-    // Write entry 0
     ProfilerEntry* profilerEntry = &threadData->entries[threadData->currentEntry];
-    threadData->entryStack[threadData->callStackDepth] = threadData->currentEntry;
 
     if (threadData->callStackDepth > 0)
     {
@@ -336,10 +442,26 @@ void PushSectionBase(const char* szSection, unsigned int color, const char* szFi
     profilerEntry->startTime = timer_get_elapsed(gTimer).count();
     profilerEntry->endTime = std::numeric_limits<int64_t>::max();
     profilerEntry->level = threadData->callStackDepth;
-    threadData->callStackDepth++;
+    profilerEntry->flags = EntryFlags_None;
+    profilerEntry->allocCount = 0;
+    profilerEntry->freeCount = 0;
+    profilerEntry->allocBytes = 0;
+    profilerEntry->freeBytes = 0;
+    profilerEntry->peakBytes = 0;
+
+    // Args are dropped if the side buffer is full
+    profilerEntry->firstArg = threadData->currentArg;
+    profilerEntry->argCount = 0;
+    if (args.size() > 0 && (threadData->currentArg + args.size()) <= threadData->args.size())
+    {
+        std::copy(args.begin(), args.end(), threadData->args.begin() + threadData->currentArg);
+        profilerEntry->argCount = uint32_t(args.size());
+        threadData->currentArg += uint32_t(args.size());
+    }
+
     threadData->currentEntry++;
 
-    threadData->maxLevel = std::max(threadData->maxLevel, threadData->callStackDepth);
+    threadData->maxLevel = std::max(threadData->maxLevel, threadData->callStackDepth + 1);
 
     threadData->minTime = std::min(profilerEntry->startTime, threadData->minTime);
     threadData->maxTime = std::max(profilerEntry->startTime, threadData->maxTime);
@@ -362,6 +484,57 @@ void PushSectionBase(const char* szSection, unsigned int color, const char* szFi
     {
         gRestarting = false;
     }
+    return profilerEntry;
+}
+
+void PushSectionBase(const char* szSection, unsigned int color, const char* szFile, int line, std::initializer_list<ProfileArg> args)
+{
+    if (gPaused)
+    {
+        return;
+    }
+
+    ThreadData* threadData = GetThreadData();
+    if (CheckEndState())
+    {
+        return;
+    }
+
+    // check again
+    if (gPaused)
+    {
+        return;
+    }
+
+    // Too deep (likely instrumented code); drop the scope but remember it so the pop matches
+    if (threadData->droppedDepth > 0 || threadData->callStackDepth >= threadData->entryStack.size())
+    {
+        threadData->droppedDepth++;
+        return;
+    }
+
+    threadData->entryStack[threadData->callStackDepth] = threadData->currentEntry;
+    WriteEntry(threadData, szSection, color, szFile, line, args);
+    threadData->callStackDepth++;
+}
+
+// An instant event; written as a zero length child of the current scope
+void Mark(const char* szSection, unsigned int color, const char* szFile, int line, std::initializer_list<ProfileArg> args)
+{
+    if (gPaused)
+    {
+        return;
+    }
+
+    ThreadData* threadData = GetThreadData();
+    if (CheckEndState())
+    {
+        return;
+    }
+
+    auto profilerEntry = WriteEntry(threadData, szSection, color, szFile, line, args);
+    profilerEntry->endTime = profilerEntry->startTime;
+    profilerEntry->flags |= EntryFlags_Mark;
 }
 
 void PopSection()
@@ -382,6 +555,12 @@ void PopSection()
         return;
     }
 
+    if (threadData->droppedDepth > 0)
+    {
+        threadData->droppedDepth--;
+        return;
+    }
+
     if (threadData->callStackDepth <= 0)
     {
         return;
@@ -401,11 +580,168 @@ void PopSection()
     threadData->maxTime = std::max(profilerEntry->endTime, threadData->maxTime);
 }
 
+// Add a sample to a counter track; the name must be a static string
+void Counter(const char* pszName, double value)
+{
+    if (gPaused)
+    {
+        return;
+    }
+
+    ThreadData* threadData = GetThreadData();
+    if (!threadData || CheckEndState())
+    {
+        return;
+    }
+
+    // Counters just stop when full, they don't end the capture
+    if (threadData->currentCounter >= threadData->counters.size())
+    {
+        return;
+    }
+
+    auto& sample = threadData->counters[threadData->currentCounter];
+    sample.szName = pszName;
+    sample.time = timer_get_elapsed(gTimer).count();
+    sample.value = value;
+    threadData->currentCounter++;
+}
+
+// The entry which receives allocations on this thread.
+// Called from inside the allocator, so it must not lock, allocate or initialize a new thread
+ProfilerEntry* GetAllocationEntry()
+{
+    if (gPaused || gThreadIndexTLS == -1 || gGenerationTLS != gProfilerGeneration.load(std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    if (uint32_t(gThreadIndexTLS) >= gProfilerData->threadData.size())
+    {
+        return nullptr;
+    }
+
+    auto& threadData = gProfilerData->threadData[gThreadIndexTLS];
+    if (threadData.callStackDepth == 0)
+    {
+        return nullptr;
+    }
+    return &threadData.entries[threadData.entryStack[threadData.callStackDepth - 1]];
+}
+
+void TrackAlloc(size_t size)
+{
+    auto live = gLiveBytes.fetch_add(int64_t(size), std::memory_order_relaxed) + int64_t(size);
+    auto peak = gPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !gPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+
+    if (auto pEntry = GetAllocationEntry())
+    {
+        pEntry->allocCount++;
+        pEntry->allocBytes += int64_t(size);
+        pEntry->peakBytes = std::max(pEntry->peakBytes, pEntry->allocBytes - pEntry->freeBytes);
+    }
+}
+
+void TrackFree(size_t size)
+{
+    gLiveBytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+
+    if (auto pEntry = GetAllocationEntry())
+    {
+        pEntry->freeCount++;
+        pEntry->freeBytes += int64_t(size);
+    }
+}
+
 void SetRegionLimit(uint64_t maxTimeNs)
 {
     gProfilerData->regionTimeLimit = maxTimeNs;
 }
 
+void SetFramePeriod(uint64_t periodNs)
+{
+    gProfilerData->framePeriod = periodNs;
+}
+
+void SetRegionPeriod(uint64_t periodNs)
+{
+    gProfilerData->regionPeriod = periodNs;
+}
+
+// Spans are (start, end) pairs in capture order; intervals are measured start to start
+PacingStats AnalyzePacing(const std::vector<glm::i64vec2>& spans, int64_t periodNs, uint32_t histogramBuckets)
+{
+    PacingStats stats;
+    if (spans.size() < 2)
+    {
+        return stats;
+    }
+
+    stats.intervalTimes.reserve(spans.size() - 1);
+    stats.minInterval = std::numeric_limits<int64_t>::max();
+    stats.maxInterval = std::numeric_limits<int64_t>::min();
+
+    double sum = 0.0;
+    for (size_t index = 1; index < spans.size(); index++)
+    {
+        auto interval = spans[index].x - spans[index - 1].x;
+        stats.intervalTimes.push_back(interval);
+        stats.minInterval = std::min(stats.minInterval, interval);
+        stats.maxInterval = std::max(stats.maxInterval, interval);
+        sum += double(interval);
+    }
+
+    stats.intervals = uint32_t(stats.intervalTimes.size());
+    stats.meanInterval = sum / stats.intervals;
+    stats.period = periodNs > 0 ? periodNs : int64_t(stats.meanInterval);
+
+    double sumSquares = 0.0;
+    for (auto interval : stats.intervalTimes)
+    {
+        auto diff = double(interval) - stats.meanInterval;
+        sumSquares += diff * diff;
+        stats.maxDeviation = std::max(stats.maxDeviation, std::abs(interval - stats.period));
+    }
+    stats.jitter = std::sqrt(sumSquares / stats.intervals);
+
+    // Deadlines only mean something against a real target
+    if (periodNs > 0)
+    {
+        // Half a period late means the consumer saw a repeated or skipped slot
+        const auto missedThreshold = periodNs + periodNs / 2;
+        for (auto interval : stats.intervalTimes)
+        {
+            if (interval > missedThreshold)
+            {
+                stats.missedDeadlines++;
+            }
+        }
+
+        for (auto& span : spans)
+        {
+            if (span.y > span.x && (span.y - span.x) > periodNs)
+            {
+                stats.overruns++;
+            }
+        }
+    }
+
+    histogramBuckets = std::max(histogramBuckets, 1u);
+    stats.histogram.resize(histogramBuckets, 0);
+    stats.histogramStart = stats.minInterval;
+    stats.histogramBucketSize = std::max(int64_t(1), (stats.maxInterval - stats.minInterval + histogramBuckets) / histogramBuckets);
+    for (auto interval : stats.intervalTimes)
+    {
+        auto bucket = std::min(uint32_t((interval - stats.histogramStart) / stats.histogramBucketSize), histogramBuckets - 1);
+        stats.histogram[bucket]++;
+    }
+
+    return stats;
+}
+
 void NameThread(const char* pszName)
 {
     if (gPaused)
@@ -502,6 +838,11 @@ void NewFrame()
         gProfilerData->frameData[gProfilerData->currentFrame - 1].name = std::format("{:.2f}ms", float(timer_to_ms(nanoseconds(frame.startTime - gProfilerData->frameData[gProfilerData->currentFrame - 1].startTime))));
     }
     gProfilerData->currentFrame++;
+
+#ifdef ZEST_PROFILE_MEMORY
+    gProfilerData->peakBytes = gPeakBytes.load();
+    Counter(MemoryCounterName, double(gLiveBytes.load()));
+#endif
 }
 
 // Which frames we can see in the main viewport for the current zoom
@@ -869,72 +1210,804 @@ glm::u64vec2 ShowCandles(glm::vec2& regionMin, glm::vec2& regionMax)
     return dragTimeRange;
 }
 
-// Show the profiler window
-void ShowProfile()
+// Show a strip for each named counter, covering the visible time range
+void ShowCounterTracks(glm::vec2& regionMin, const glm::vec2& regionMax)
 {
-    if (gHideUI)
+    struct CounterTrack
     {
-        return;
-    }
-    PROFILE_SCOPE(Profile_UI);
-
-    bool pause = gPaused;
-    bool changed = false;
-
-    if (pause != gRequestPause)
-    {
-        changed = true;
-        pause = gRequestPause;
-    }
-
-    if (ImGui::Button(pause ? "Resume" : "Pause"))
-    {
-        changed = true;
-        pause = !pause;
-    }
+        const char* szName = nullptr;
+        bool memory = false; // The live heap size, shown in bytes
+        double minValue = std::numeric_limits<double>::max();
+        double maxValue = std::numeric_limits<double>::lowest();
+        std::vector<const CounterSample*> samples;
+    };
+    std::vector<CounterTrack> tracks;
 
-    if (changed)
+    // Gather the visible samples for each counter, across all threads
+    for (auto& threadData : gProfilerData->threadData)
     {
-        // Call reset before setting paused
-        if (!pause)
+        if (!threadData.initialized || threadData.hidden || threadData.currentCounter == 0)
         {
-            Reset();
+            continue;
         }
-        gPaused = pause;
-        gRequestPause = pause;
-    }
-
-    ImGui::SameLine();
 
-    static float scale = 1.0f;
+        auto itrEnd = threadData.counters.begin() + threadData.currentCounter;
+        auto itr = std::lower_bound(threadData.counters.begin(), itrEnd, gTimeRange.x, [](const CounterSample& sample, int64_t time) {
+            return sample.time < time;
+        });
 
-    ImGui::PushItemWidth(100 * dpi.scaleFactorXY.x);
-    ImGui::SliderFloat("Scale", &scale, .5f, 2.0f, "%.2f");
+        // Include the sample before the range, so the value at the left edge is known
+        if (itr != threadData.counters.begin())
+        {
+            itr--;
+        }
 
-    ImGui::SameLine();
+        for (; itr != itrEnd && itr->time <= gTimeRange.y; itr++)
+        {
+            if (!itr->szName)
+            {
+                continue;
+            }
 
-    ImGui::TextUnformatted(std::format("  UI FPS {:.1f}", ImGui::GetIO().Framerate).c_str());
+            auto itrTrack = std::find_if(tracks.begin(), tracks.end(), [&](const CounterTrack& track) {
+                return strcmp(track.szName, itr->szName) == 0;
+            });
+            if (itrTrack == tracks.end())
+            {
+                itrTrack = tracks.insert(tracks.end(), CounterTrack{ itr->szName, strcmp(itr->szName, MemoryCounterName) == 0 });
+            }
+            itrTrack->samples.push_back(&*itr);
+            itrTrack->minValue = std::min(itrTrack->minValue, itr->value);
+            itrTrack->maxValue = std::max(itrTrack->maxValue, itr->value);
+        }
+    }
 
-    // Ignore the first frame, which is likely a long delay due to
-    // the time that expires after this profiler is created and the first
-    // frame is drawn
-    const uint32_t MaxFrame = gProfilerData->currentFrame - 2;
-    if (gProfilerData->currentFrame < MinLeadInFrames)
+    if (tracks.empty())
     {
         return;
     }
 
-    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
-
-    auto regionSize = ImGui::GetContentRegionAvail();
-    glm::vec2 regionMin(ImGui::GetCursorScreenPos());
-    glm::vec2 regionMax(regionMin.x + regionSize.x, regionMin.y + regionSize.y);
-    glm::vec2 topLeft = regionMin;
+    const float TrackHeight = 30 * dpi.scaleFactorXY.y;
+    const auto textPadding = glm::vec2(3, 3) * dpi.scaleFactorXY;
+    const auto pDrawList = ImGui::GetWindowDrawList();
+    const auto width = regionMax.x - regionMin.x;
+    const auto visibleDuration = double(gTimeRange.y - gTimeRange.x);
 
-    auto pDrawList = ImGui::GetWindowDrawList();
+    auto xFromTime = [&](int64_t time) {
+        return regionMin.x + float(std::clamp((time - gTimeRange.x) / visibleDuration, 0.0, 1.0) * width);
+    };
 
-    // Always background fill the profiler
-    pDrawList->AddRectFilled(ImVec2(regionMin.x, regionMin.y), ImVec2(regionMax.x, regionMax.y), 0xFF111111);
+    for (auto& track : tracks)
+    {
+        std::sort(track.samples.begin(), track.samples.end(), [](auto lhs, auto rhs) {
+            return lhs->time < rhs->time;
+        });
+
+        NRectf rc(regionMin.x, regionMin.y, width, TrackHeight);
+        pDrawList->AddRectFilled(rc.topLeftPx, rc.bottomRightPx, 0xFF1A1A1A);
+
+        const auto range = std::max(track.maxValue - track.minValue, 1.0);
+        auto yFromValue = [&](double value) {
+            return rc.Bottom() - 2.0f - float((value - track.minValue) / range) * (rc.Height() - 4.0f);
+        };
+
+        // Step graph; each sample holds until the next one
+        const auto* pHover = track.samples[0];
+        auto mouseX = ImGui::GetMousePos().x;
+        for (size_t index = 0; index < track.samples.size(); index++)
+        {
+            auto pSample = track.samples[index];
+            auto x0 = xFromTime(pSample->time);
+            auto x1 = (index + 1) < track.samples.size() ? xFromTime(track.samples[index + 1]->time) : rc.Right();
+            auto y0 = yFromValue(pSample->value);
+            pDrawList->AddLine(ImVec2(x0, y0), ImVec2(x1, y0), 0xFF44AAFF);
+            if ((index + 1) < track.samples.size())
+            {
+                pDrawList->AddLine(ImVec2(x1, y0), ImVec2(x1, yFromValue(track.samples[index + 1]->value)), 0xFF44AAFF);
+            }
+
+            if (mouseX >= x0)
+            {
+                pHover = pSample;
+            }
+        }
+
+        auto formatValue = [&](double value) {
+            return track.memory ? FormatBytes(int64_t(value)) : std::format("{:.2f}", value);
+        };
+
+        auto label = std::format("{}: {}", track.szName, formatValue(track.samples.back()->value));
+        if (track.memory)
+        {
+            label += std::format(" (Peak {})", FormatBytes(gProfilerData->peakBytes));
+        }
+        pDrawList->AddText(ImVec2(rc.Left() + textPadding.x, rc.Top() + textPadding.y), 0xFFAAAAAA, label.c_str());
+
+        if (ImGui::IsMouseHoveringRect(rc.topLeftPx, rc.bottomRightPx))
+        {
+            auto tip = std::format("{}: {}\nRange: {} - {}", track.szName, formatValue(pHover->value), formatValue(track.minValue), formatValue(track.maxValue));
+            ImGui::SetTooltip("%s", tip.c_str());
+        }
+
+        regionMin.y += TrackHeight;
+    }
+
+    ImGui::Dummy(ImVec2(width, TrackHeight * tracks.size()));
+}
+
+void ShowPacingTrack(const char* pszName, const std::vector<glm::i64vec2>& spans, int64_t& period)
+{
+    ImGui::PushID(pszName);
+
+    auto periodMs = float(timer_to_ms(nanoseconds(period)));
+    ImGui::TextUnformatted(pszName);
+    ImGui::SameLine();
+    ImGui::PushItemWidth(100 * dpi.scaleFactorXY.x);
+    if (ImGui::InputFloat("Period (ms)", &periodMs, 0.0f, 0.0f, "%.3f"))
+    {
+        period = int64_t(std::max(periodMs, 0.0f) * 1000000.0);
+    }
+    ImGui::PopItemWidth();
+
+    auto stats = AnalyzePacing(spans, period);
+    if (stats.intervals == 0)
+    {
+        ImGui::TextUnformatted("No intervals captured");
+        ImGui::PopID();
+        return;
+    }
+
+    auto toMs = [](auto time) {
+        return timer_to_ms(nanoseconds(int64_t(time)));
+    };
+
+    ImGui::TextUnformatted(std::format("Intervals {}  Mean {:.3f}ms  Jitter {:.3f}ms  Min {:.3f}ms  Max {:.3f}ms  Max Deviation {:.3f}ms",
+        stats.intervals, toMs(stats.meanInterval), toMs(stats.jitter), toMs(stats.minInterval), toMs(stats.maxInterval), toMs(stats.maxDeviation))
+                               .c_str());
+    if (period > 0)
+    {
+        ImGui::TextUnformatted(std::format("Missed Deadlines {} ({:.2f}%)  Overruns {}", stats.missedDeadlines, 100.0 * stats.missedDeadlines / stats.intervals, stats.overruns).c_str());
+    }
+
+    const auto GraphHeight = 80.0f * dpi.scaleFactorXY.y;
+    const auto textPadding = glm::vec2(3, 3) * dpi.scaleFactorXY;
+    const auto pDrawList = ImGui::GetWindowDrawList();
+    const auto missedThreshold = period > 0 ? period + period / 2 : std::numeric_limits<int64_t>::max();
+
+    glm::vec2 topLeft(ImGui::GetCursorScreenPos());
+    const auto width = ImGui::GetContentRegionAvail().x;
+    const auto histogramWidth = width * .3f;
+
+    // Histogram of intervals, with the target period marked
+    NRectf rcHistogram(topLeft.x, topLeft.y, histogramWidth - textPadding.x, GraphHeight);
+    pDrawList->AddRectFilled(rcHistogram.topLeftPx, rcHistogram.bottomRightPx, 0xFF1A1A1A);
+
+    const auto maxCount = float(*std::max_element(stats.histogram.begin(), stats.histogram.end()));
+    const auto bucketWidth = rcHistogram.Width() / stats.histogram.size();
+    int hoverBucket = -1;
+    for (uint32_t bucket = 0; bucket < stats.histogram.size(); bucket++)
+    {
+        auto bucketStart = stats.histogramStart + bucket * stats.histogramBucketSize;
+        auto x = rcHistogram.Left() + bucket * bucketWidth;
+        auto y = rcHistogram.Bottom() - (stats.histogram[bucket] / maxCount) * (rcHistogram.Height() - textPadding.y);
+        auto color = bucketStart > missedThreshold ? 0xFF4444FF : 0xFF44AAFF;
+        pDrawList->AddRectFilled(ImVec2(x, y), ImVec2(x + std::max(bucketWidth - 1.0f, 1.0f), rcHistogram.Bottom()), color);
+
+        if (ImGui::IsMouseHoveringRect(ImVec2(x, rcHistogram.Top()), ImVec2(x + bucketWidth, rcHistogram.Bottom())))
+        {
+            hoverBucket = int(bucket);
+        }
+    }
+
+    auto xFromInterval = [&](int64_t interval) {
+        auto range = double(stats.histogramBucketSize) * stats.histogram.size();
+        return rcHistogram.Left() + float(std::clamp((interval - stats.histogramStart) / range, 0.0, 1.0)) * rcHistogram.Width();
+    };
+    auto periodX = xFromInterval(stats.period);
+    pDrawList->AddLine(ImVec2(periodX, rcHistogram.Top()), ImVec2(periodX, rcHistogram.Bottom()), 0xFFFFFFFF);
+
+    if (hoverBucket >= 0)
+    {
+        auto bucketStart = stats.histogramStart + hoverBucket * stats.histogramBucketSize;
+        ImGui::SetTooltip("%s", std::format("{:.3f}ms - {:.3f}ms: {}", toMs(bucketStart), toMs(bucketStart + stats.histogramBucketSize), stats.histogram[hoverBucket]).c_str());
+    }
+
+    // Pacing graph; one column per pixel showing the worst interval that lands in it
+    NRectf rcGraph(topLeft.x + histogramWidth, topLeft.y, width - histogramWidth, GraphHeight);
+    pDrawList->AddRectFilled(rcGraph.topLeftPx, rcGraph.bottomRightPx, 0xFF1A1A1A);
+
+    const auto graphMax = double(std::max(stats.maxInterval, stats.period * 2));
+    auto yFromInterval = [&](int64_t interval) {
+        return rcGraph.Bottom() - float(std::min(interval / graphMax, 1.0)) * (rcGraph.Height() - textPadding.y);
+    };
+
+    const auto columns = std::max(int(rcGraph.Width()), 1);
+    const auto intervalsPerColumn = double(stats.intervals) / columns;
+    auto mouseX = ImGui::GetMousePos().x;
+    for (int column = 0; column < columns; column++)
+    {
+        auto first = size_t(column * intervalsPerColumn);
+        auto last = std::max(size_t((column + 1) * intervalsPerColumn), first + 1);
+        if (first >= stats.intervalTimes.size())
+        {
+            break;
+        }
+        last = std::min(last, stats.intervalTimes.size());
+
+        auto worst = *std::max_element(stats.intervalTimes.begin() + first, stats.intervalTimes.begin() + last);
+        auto x = rcGraph.Left() + column;
+        pDrawList->AddLine(ImVec2(x, rcGraph.Bottom()), ImVec2(x, yFromInterval(worst)), worst > missedThreshold ? 0xFF4444FF : 0xFF44AAFF);
+
+        if (ImGui::IsMouseHoveringRect(rcGraph.topLeftPx, rcGraph.bottomRightPx) && mouseX >= x && mouseX < (x + 1))
+        {
+            ImGui::SetTooltip("%s", std::format("#{}: {:.3f}ms", first, toMs(worst)).c_str());
+        }
+    }
+
+    auto periodY = yFromInterval(stats.period);
+    pDrawList->AddLine(ImVec2(rcGraph.Left(), periodY), ImVec2(rcGraph.Right(), periodY), 0xFFFFFFFF);
+    pDrawList->AddText(ImVec2(rcGraph.Left() + textPadding.x, rcGraph.Top() + textPadding.y), 0xFFAAAAAA, std::format("{:.3f}ms", toMs(graphMax)).c_str());
+
+    ImGui::Dummy(ImVec2(width, GraphHeight + textPadding.y));
+    ImGui::PopID();
+}
+
+// Index any entries written since the last call, up to the budget
+void UpdateSearchIndex(uint32_t budget)
+{
+    // Start again for a new capture
+    if (gSearch.pData != gProfilerData.get() || gSearch.generation != gProfilerGeneration.load())
+    {
+        gSearch.pData = gProfilerData.get();
+        gSearch.generation = gProfilerGeneration.load();
+        gSearch.threads.clear();
+        gSearch.matchedQuery.clear();
+        gSearch.matchedSections.clear();
+        gSearch.slowest.clear();
+        gSearch.hasCursor = false;
+    }
+    gSearch.threads.resize(gProfilerData->threadData.size());
+
+    gSearch.indexing = false;
+    for (uint32_t threadIndex = 0; threadIndex < gProfilerData->threadData.size(); threadIndex++)
+    {
+        const auto& threadData = gProfilerData->threadData[threadIndex];
+        auto& index = gSearch.threads[threadIndex];
+        if (!threadData.initialized)
+        {
+            continue;
+        }
+
+        // The thread slot was reused
+        if (index.indexedEntries > threadData.currentEntry)
+        {
+            index = SearchThreadIndex();
+            gSearch.sitesChanged = true;
+        }
+
+        // While capturing, the last entry may still be being written
+        auto available = gPaused ? threadData.currentEntry : std::max(threadData.currentEntry, 1u) - 1;
+        auto end = std::min(available, index.indexedEntries + budget);
+        budget -= end - std::min(end, index.indexedEntries);
+        gSearch.indexing |= end < available;
+
+        for (; index.indexedEntries < end; index.indexedEntries++)
+        {
+            const auto& entry = threadData.entries[index.indexedEntries];
+            if (!entry.szSection)
+            {
+                continue;
+            }
+
+            auto [itrSite, inserted] = index.siteLookup.try_emplace(entry.szSection, uint32_t(index.sites.size()));
+            if (inserted)
+            {
+                index.sites.push_back(SearchSite{ entry.szSection });
+                gSearch.sitesChanged = true;
+            }
+
+            auto& site = index.sites[itrSite->second];
+            site.entries.push_back(index.indexedEntries);
+
+            // Args are searchable by name
+            for (uint32_t arg = entry.firstArg; arg < (entry.firstArg + entry.argCount) && arg < threadData.args.size(); arg++)
+            {
+                auto szName = threadData.args[arg].szName;
+                if (szName && std::find(site.argNames.begin(), site.argNames.end(), szName) == site.argNames.end())
+                {
+                    site.argNames.push_back(szName);
+                    gSearch.sitesChanged = true;
+                }
+            }
+        }
+    }
+}
+
+// Find the sites which match the query; cheap, since it only visits sites, not entries
+void UpdateSearchMatches()
+{
+    if (gSearch.query != gSearch.matchedQuery || gSearch.sitesChanged)
+    {
+        gSearch.matchedQuery = gSearch.query;
+        gSearch.sitesChanged = false;
+        gSearch.matchedSections.clear();
+
+        auto contains = [](const char* szText, const std::string& query) {
+            auto itr = std::search(szText, szText + strlen(szText), query.begin(), query.end(), [](char lhs, char rhs) {
+                return std::tolower((unsigned char)lhs) == std::tolower((unsigned char)rhs);
+            });
+            return *itr != 0;
+        };
+
+        for (auto& index : gSearch.threads)
+        {
+            index.matchedSites.clear();
+            for (uint32_t siteIndex = 0; siteIndex < index.sites.size(); siteIndex++)
+            {
+                const auto& site = index.sites[siteIndex];
+                bool match = contains(site.szSection, gSearch.query) || std::any_of(site.argNames.begin(), site.argNames.end(), [&](const char* szName) {
+                    return contains(szName, gSearch.query);
+                });
+
+                if (match)
+                {
+                    index.matchedSites.push_back(siteIndex);
+                    gSearch.matchedSections.insert(site.szSection);
+                }
+            }
+        }
+    }
+
+    // Entries keep arriving for matched sites while capturing
+    gSearch.matchCount = 0;
+    for (uint32_t threadIndex = 0; threadIndex < gSearch.threads.size(); threadIndex++)
+    {
+        const auto& index = gSearch.threads[threadIndex];
+        if (gProfilerData->threadData[threadIndex].hidden)
+        {
+            continue;
+        }
+        for (auto siteIndex : index.matchedSites)
+        {
+            gSearch.matchCount += index.sites[siteIndex].entries.size();
+        }
+    }
+}
+
+int64_t SearchEntryDuration(const SearchResult& result)
+{
+    const auto& threadData = gProfilerData->threadData[result.threadIndex];
+    const auto& entry = threadData.entries[result.entryIndex];
+    return std::min(entry.endTime, threadData.maxTime) - entry.startTime;
+}
+
+// Move the view to a match, keeping the zoom unless the entry doesn't fit
+void JumpToSearchResult(const SearchResult& result)
+{
+    gSearch.hasCursor = true;
+    gSearch.cursor = result;
+
+    const auto& entry = gProfilerData->threadData[result.threadIndex].entries[result.entryIndex];
+    auto duration = std::max(SearchEntryDuration(result), int64_t(1000));
+    auto visible = gTimeRange.y - gTimeRange.x;
+    if (duration * 5 > visible * 4)
+    {
+        visible = duration + duration / 2;
+    }
+
+    auto center = entry.startTime + duration / 2;
+    gTimeRange = glm::i64vec2(center - visible / 2, center + visible / 2);
+    gCandleDragRect.Clear();
+}
+
+// Step to the next/previous match in time, from the current match or the center of the view; false if there isn't one
+bool JumpToNextSearchResult(bool forward)
+{
+    using Key = std::tuple<int64_t, uint32_t, uint32_t>;
+    auto keyFromEntry = [](uint32_t threadIndex, uint32_t entryIndex) {
+        return Key(gProfilerData->threadData[threadIndex].entries[entryIndex].startTime, threadIndex, entryIndex);
+    };
+
+    auto from = gSearch.hasCursor ? keyFromEntry(gSearch.cursor.threadIndex, gSearch.cursor.entryIndex) : Key((gTimeRange.x + gTimeRange.y) / 2, 0, 0);
+
+    bool found = false;
+    Key best;
+    for (uint32_t threadIndex = 0; threadIndex < gSearch.threads.size(); threadIndex++)
+    {
+        const auto& index = gSearch.threads[threadIndex];
+        if (gProfilerData->threadData[threadIndex].hidden)
+        {
+            continue;
+        }
+
+        for (auto siteIndex : index.matchedSites)
+        {
+            const auto& entries = index.sites[siteIndex].entries;
+            if (forward)
+            {
+                auto itr = std::upper_bound(entries.begin(), entries.end(), from, [&](const Key& key, uint32_t entryIndex) {
+                    return key < keyFromEntry(threadIndex, entryIndex);
+                });
+                if (itr != entries.end() && (!found || keyFromEntry(threadIndex, *itr) < best))
+                {
+                    best = keyFromEntry(threadIndex, *itr);
+                    found = true;
+                }
+            }
+            else
+            {
+                auto itr = std::lower_bound(entries.begin(), entries.end(), from, [&](uint32_t entryIndex, const Key& key) {
+                    return keyFromEntry(threadIndex, entryIndex) < key;
+                });
+                if (itr != entries.begin() && (!found || best < keyFromEntry(threadIndex, *(itr - 1))))
+                {
+                    best = keyFromEntry(threadIndex, *(itr - 1));
+                    found = true;
+                }
+            }
+        }
+    }
+
+    if (found)
+    {
+        JumpToSearchResult(SearchResult{ std::get<1>(best), std::get<2>(best) });
+    }
+    return found;
+}
+
+// Keep the longest N matches in a min heap
+void FindSlowestSearchResults()
+{
+    auto slower = [](const SearchResult& lhs, const SearchResult& rhs) {
+        return lhs.duration > rhs.duration;
+    };
+
+    auto& slowest = gSearch.slowest;
+    slowest.clear();
+    for (uint32_t threadIndex = 0; threadIndex < gSearch.threads.size(); threadIndex++)
+    {
+        const auto& index = gSearch.threads[threadIndex];
+        if (gProfilerData->threadData[threadIndex].hidden)
+        {
+            continue;
+        }
+
+        for (auto siteIndex : index.matchedSites)
+        {
+            for (auto entryIndex : index.sites[siteIndex].entries)
+            {
+                SearchResult result{ threadIndex, entryIndex };
+                result.duration = SearchEntryDuration(result);
+                if (slowest.size() < size_t(gSearch.slowestCount))
+                {
+                    slowest.push_back(result);
+                    std::push_heap(slowest.begin(), slowest.end(), slower);
+                }
+                else if (result.duration > slowest.front().duration)
+                {
+                    std::pop_heap(slowest.begin(), slowest.end(), slower);
+                    slowest.back() = result;
+                    std::push_heap(slowest.begin(), slowest.end(), slower);
+                }
+            }
+        }
+    }
+    std::sort_heap(slowest.begin(), slowest.end(), slower);
+}
+
+uint64_t Search(const std::string& query, uint32_t maxEntries)
+{
+    gSearch.query = query;
+    UpdateSearchIndex(maxEntries);
+    UpdateSearchMatches();
+    return gSearch.matchCount;
+}
+
+bool IsSearchIndexing()
+{
+    return gSearch.indexing;
+}
+
+bool SearchStep(bool forward, SearchResult& result)
+{
+    if (!JumpToNextSearchResult(forward))
+    {
+        return false;
+    }
+    result = gSearch.cursor;
+    result.duration = SearchEntryDuration(result);
+    return true;
+}
+
+std::vector<SearchResult> SearchSlowest(int count)
+{
+    gSearch.slowestCount = count;
+    FindSlowestSearchResults();
+    return gSearch.slowest;
+}
+
+// Search box, next/previous and slowest instance navigation
+void ShowSearch()
+{
+    static char searchText[256] = "";
+
+    ImGui::PushItemWidth(200 * dpi.scaleFactorXY.x);
+    ImGui::InputTextWithHint("##ProfileSearch", "Search", searchText, sizeof(searchText));
+    ImGui::PopItemWidth();
+
+    gSearch.query = searchText;
+    if (gSearch.query.empty())
+    {
+        gSearch.matchedQuery.clear();
+        gSearch.matchedSections.clear();
+        gSearch.hasCursor = false;
+        return;
+    }
+
+    UpdateSearchIndex(MaxEntriesIndexedPerFrame);
+    UpdateSearchMatches();
+
+    // Can only navigate a paused capture
+    ImGui::BeginDisabled(!gPaused);
+
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##SearchPrev", ImGuiDir_Left))
+    {
+        JumpToNextSearchResult(false);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##SearchNext", ImGuiDir_Right))
+    {
+        JumpToNextSearchResult(true);
+    }
+
+    ImGui::SameLine();
+    ImGui::PushItemWidth(60 * dpi.scaleFactorXY.x);
+    if (ImGui::InputInt("##SlowestCount", &gSearch.slowestCount, 0))
+    {
+        gSearch.slowestCount = std::clamp(gSearch.slowestCount, 1, 1000);
+    }
+    ImGui::PopItemWidth();
+
+    ImGui::SameLine();
+    if (ImGui::Button("Slowest"))
+    {
+        FindSlowestSearchResults();
+        ImGui::OpenPopup("##SlowestPopup");
+    }
+
+    if (ImGui::BeginPopup("##SlowestPopup"))
+    {
+        for (uint32_t index = 0; index < gSearch.slowest.size(); index++)
+        {
+            const auto& result = gSearch.slowest[index];
+            const auto& threadData = gProfilerData->threadData[result.threadIndex];
+            const auto& entry = threadData.entries[result.entryIndex];
+            auto label = std::format("{}: {:.4f}ms @ {:.4f}ms ({})##{}", entry.szSection, timer_to_ms(nanoseconds(result.duration)), timer_to_ms(nanoseconds(entry.startTime)), threadData.name, index);
+            if (ImGui::Selectable(label.c_str(), gSearch.hasCursor && gSearch.cursor.entryIndex == result.entryIndex && gSearch.cursor.threadIndex == result.threadIndex))
+            {
+                JumpToSearchResult(result);
+            }
+        }
+        ImGui::EndPopup();
+    }
+
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::TextUnformatted(std::format("  {} matches{}", gSearch.matchCount, gSearch.indexing ? " (indexing)" : "").c_str());
+}
+
+// Interval analysis of the frames and regions captured so far
+void ShowPacing()
+{
+    if (gHideUI || gProfilerData->currentFrame < MinLeadInFrames)
+    {
+        return;
+    }
+
+    // Skip the lead in frames; the last frame has not finished yet
+    std::vector<glm::i64vec2> spans;
+    for (uint32_t frameIndex = MinFrame; frameIndex < gProfilerData->currentFrame - 1; frameIndex++)
+    {
+        const auto& frame = gProfilerData->frameData[frameIndex];
+        spans.emplace_back(frame.startTime, frame.endTime);
+    }
+    ShowPacingTrack("Frames", spans, gProfilerData->framePeriod);
+
+    spans.clear();
+    for (uint32_t regionIndex = 0; regionIndex < gProfilerData->currentRegion; regionIndex++)
+    {
+        const auto& region = gProfilerData->regionData[regionIndex];
+        spans.emplace_back(region.startTime, region.endTime);
+    }
+    if (!spans.empty())
+    {
+        ShowPacingTrack("Regions", spans, gProfilerData->regionPeriod);
+    }
+}
+
+// Allocation totals per scope over the visible time range, the scopes that allocate most first
+void ShowAllocs()
+{
+    if (gHideUI || gProfilerData->currentFrame < MinLeadInFrames)
+    {
+        return;
+    }
+
+    struct ScopeAllocs
+    {
+        std::string_view name;
+        uint32_t calls = 0;
+        uint32_t allocCount = 0;
+        uint32_t freeCount = 0;
+        int64_t allocBytes = 0;
+        int64_t freeBytes = 0;
+        int64_t peakBytes = 0;
+    };
+
+    std::unordered_map<std::string_view, ScopeAllocs> scopes;
+    for (auto& threadData : gProfilerData->threadData)
+    {
+        if (!threadData.initialized || threadData.hidden)
+        {
+            continue;
+        }
+
+        for (uint32_t index = 0; index < threadData.currentEntry; index++)
+        {
+            const auto& entry = threadData.entries[index];
+            if ((entry.allocCount == 0 && entry.freeCount == 0) || !entry.szSection || entry.startTime > gTimeRange.y || entry.endTime < gTimeRange.x)
+            {
+                continue;
+            }
+
+            auto& scope = scopes[entry.szSection];
+            scope.name = entry.szSection;
+            scope.calls++;
+            scope.allocCount += entry.allocCount;
+            scope.freeCount += entry.freeCount;
+            scope.allocBytes += entry.allocBytes;
+            scope.freeBytes += entry.freeBytes;
+            scope.peakBytes = std::max(scope.peakBytes, entry.peakBytes);
+        }
+    }
+
+    if (scopes.empty())
+    {
+        ImGui::TextUnformatted("No allocations in view");
+        return;
+    }
+
+    std::vector<ScopeAllocs> rows;
+    rows.reserve(scopes.size());
+    for (auto& [name, scope] : scopes)
+    {
+        rows.push_back(scope);
+    }
+    std::sort(rows.begin(), rows.end(), [](const ScopeAllocs& lhs, const ScopeAllocs& rhs) {
+        return lhs.allocCount != rhs.allocCount ? lhs.allocCount > rhs.allocCount : lhs.allocBytes > rhs.allocBytes;
+    });
+
+    const auto flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+    const auto height = std::min(rows.size() + 1, size_t(8)) * ImGui::GetTextLineHeightWithSpacing() + ImGui::GetStyle().CellPadding.y * 2.0f;
+    if (ImGui::BeginTable("Allocs", 6, flags, ImVec2(0.0f, height)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Allocs");
+        ImGui::TableSetupColumn("Frees");
+        ImGui::TableSetupColumn("Net");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableHeadersRow();
+
+        for (auto& row : rows)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.name.data(), row.name.data() + row.name.size());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(std::format("{}", row.calls).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(std::format("{} ({})", row.allocCount, FormatBytes(row.allocBytes)).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(std::format("{} ({})", row.freeCount, FormatBytes(row.freeBytes)).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FormatBytes(row.allocBytes - row.freeBytes).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FormatBytes(row.peakBytes).c_str());
+        }
+        ImGui::EndTable();
+    }
+}
+
+// Show the profiler window
+void ShowProfile()
+{
+    if (gHideUI)
+    {
+        return;
+    }
+    PROFILE_SCOPE(Profile_UI);
+
+    bool pause = gPaused;
+    bool changed = false;
+
+    if (pause != gRequestPause)
+    {
+        changed = true;
+        pause = gRequestPause;
+    }
+
+    if (ImGui::Button(pause ? "Resume" : "Pause"))
+    {
+        changed = true;
+        pause = !pause;
+    }
+
+    if (changed)
+    {
+        // Call reset before setting paused
+        if (!pause)
+        {
+            Reset();
+        }
+        gPaused = pause;
+        gRequestPause = pause;
+    }
+
+    ImGui::SameLine();
+
+    static float scale = 1.0f;
+
+    ImGui::PushItemWidth(100 * dpi.scaleFactorXY.x);
+    ImGui::SliderFloat("Scale", &scale, .5f, 2.0f, "%.2f");
+
+    ImGui::SameLine();
+
+    ImGui::TextUnformatted(std::format("  UI FPS {:.1f}", ImGui::GetIO().Framerate).c_str());
+
+    ImGui::SameLine();
+    ShowSearch();
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Pacing", &gShowPacing);
+
+    ImGui::SameLine();
+    ImGui::Checkbox("Allocs", &gShowAllocs);
+
+    // Ignore the first frame, which is likely a long delay due to
+    // the time that expires after this profiler is created and the first
+    // frame is drawn
+    const uint32_t MaxFrame = gProfilerData->currentFrame - 2;
+    if (gProfilerData->currentFrame < MinLeadInFrames)
+    {
+        return;
+    }
+
+    if (gShowPacing)
+    {
+        ShowPacing();
+    }
+
+    if (gShowAllocs)
+    {
+        ShowAllocs();
+    }
+
+    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 0.0f));
+
+    auto regionSize = ImGui::GetContentRegionAvail();
+    glm::vec2 regionMin(ImGui::GetCursorScreenPos());
+    glm::vec2 regionMax(regionMin.x + regionSize.x, regionMin.y + regionSize.y);
+    glm::vec2 topLeft = regionMin;
+
+    auto pDrawList = ImGui::GetWindowDrawList();
+
+    // Always background fill the profiler
+    pDrawList->AddRectFilled(ImVec2(regionMin.x, regionMin.y), ImVec2(regionMax.x, regionMax.y), 0xFF111111);
 
     auto selectedTimeRange = ShowCandles(regionMin, regionMax);
 
@@ -1004,6 +2077,9 @@ void ShowProfile()
         setTimeRange(gTimeRange);
     }
 
+    ShowCounterTracks(regionMin, regionMax);
+    regionSize = regionMax - regionMin;
+
     // Time normalized to gTimeRange.x
     auto xFromTime = [&](int64_t time) {
         return ((time - gTimeRange.x) * regionSize.x) / visibleDuration;
@@ -1117,6 +2193,14 @@ void ShowProfile()
 
             y += textPadding.y;
 
+            auto isSearchMatch = [&](uint32_t index) {
+                return !gSearch.matchedSections.empty() && gSearch.matchedSections.contains(threadData.entries[index].szSection);
+            };
+
+            auto isSearchCursor = [&](uint32_t index) {
+                return gSearch.hasCursor && gSearch.cursor.entryIndex == index && gSearch.cursor.threadIndex == frameThreadInfo.threadIndex;
+            };
+
             auto showEntry = [&](uint32_t index) {
                 auto& entry = threadData.entries[index];
 
@@ -1130,6 +2214,31 @@ void ShowProfile()
                 float xEntry = float(xFromTime(entry.startTime));
                 float xEnd = float(xFromTime(entry.endTime));
 
+                // Instant events are drawn as a marker, centered on their time
+                if (entry.flags & EntryFlags_Mark)
+                {
+                    const auto halfWidth = heightPerLevel * .3f;
+                    const auto x = xEntry + regionMin.x;
+                    ImVec2 markMin(x - halfWidth, yEntry);
+                    ImVec2 markMax(x + halfWidth, yEntry + heightPerLevel);
+                    pDrawList->AddTriangleFilled(markMin, ImVec2(markMax.x, markMin.y), ImVec2(x, markMax.y), entry.color | 0xFF000000);
+                    if (isSearchMatch(index))
+                    {
+                        pDrawList->AddTriangle(markMin, ImVec2(markMax.x, markMin.y), ImVec2(x, markMax.y), isSearchCursor(index) ? 0xFFFFFFFF : 0xFF00FFFF, 2.0f);
+                    }
+
+                    if (ImGui::IsMouseHoveringRect(markMin, markMax))
+                    {
+                        auto tip = std::format("{}: {:.4f}ms\n\n{} (Ln {})", entry.szSection, timer_to_ms(nanoseconds(entry.startTime)), entry.szFile, entry.line);
+                        if (entry.argCount > 0)
+                        {
+                            tip += "\n\n" + FormatArgs(threadData, entry);
+                        }
+                        ImGui::SetTooltip("%s", tip.c_str());
+                    }
+                    return;
+                }
+
                 // Avoid alliasing/make it easy to see small entries
                 if (xEnd < (xEntry + 1))
                 {
@@ -1140,9 +2249,28 @@ void ShowProfile()
                 ImVec2 rectMax(std::min(xEnd + regionMin.x, regionMax.x), yEntry + heightPerLevel);
                 pDrawList->AddRectFilled(rectMin, rectMax, entry.color | 0xFF000000);
 
+                if (isSearchMatch(index))
+                {
+                    pDrawList->AddRect(rectMin, rectMax, isSearchCursor(index) ? 0xFFFFFFFF : 0xFF00FFFF, 0.0f, 0, isSearchCursor(index) ? 3.0f : 2.0f);
+                }
+
+                // Mark scopes which allocated
+                if (entry.allocCount > 0)
+                {
+                    pDrawList->AddRectFilled(ImVec2(rectMin.x, rectMax.y - 2.0f * dpi.scaleFactorXY.y), rectMax, 0xFF2020FF);
+                }
+
                 if (ImGui::IsMouseHoveringRect(rectMin, rectMax))
                 {
                     auto tip = std::format("{}: {:.4f}ms ({:.2f}us)\nRange: {:.4f}ms - {:.4f}ms\n\n{} (Ln {})", entry.szSection, timer_to_ms(nanoseconds(std::min(entry.endTime, threadData.maxTime) - entry.startTime)), (std::min(entry.endTime, threadData.maxTime) - entry.startTime) / 1000.0f, timer_to_ms(nanoseconds(entry.startTime)), timer_to_ms(nanoseconds(entry.endTime)), entry.szFile, entry.line);
+                    if (entry.argCount > 0)
+                    {
+                        tip += "\n\n" + FormatArgs(threadData, entry);
+                    }
+                    if (entry.allocCount > 0 || entry.freeCount > 0)
+                    {
+                        tip += std::format("\n\nAllocs: {} ({})\nFrees: {} ({})\nPeak: {}", entry.allocCount, FormatBytes(entry.allocBytes), entry.freeCount, FormatBytes(entry.freeBytes), FormatBytes(entry.peakBytes));
+                    }
                     ImGui::SetTooltip("%s", tip.c_str());
                 }
 
@@ -1225,8 +2353,169 @@ void ShowProfile()
 const glm::vec4& ColorFromName(const char* pszName, const uint32_t len)
 {
     const auto col = murmur_hash(pszName, len, 0);
-    return DefaultColors[col % NUM_DEFAULT_COLORS];
+    return DefaultColors()[col % NUM_DEFAULT_COLORS];
 }
 
 } // namespace Profiler
 } // namespace Zest
+
+#ifdef ZEST_PROFILE_MEMORY
+// Global allocator hooks.  Sizes are taken from the heap so that a free always matches its allocation,
+// whichever delete overload the compiler picks.
+namespace
+{
+
+size_t AllocationSize(void* p, size_t alignment = 0)
+{
+#if defined(_WIN32)
+    return alignment ? _aligned_msize(p, alignment, 0) : _msize(p);
+#elif defined(__APPLE__)
+    (void)alignment;
+    return malloc_size(p);
+#else
+    (void)alignment;
+    return malloc_usable_size(p);
+#endif
+}
+
+void* TrackedMalloc(size_t size, size_t alignment = 0)
+{
+    size = std::max(size, size_t(1));
+    void* p = nullptr;
+#if defined(_WIN32)
+    p = alignment ? _aligned_malloc(size, alignment) : malloc(size);
+#else
+    if (alignment)
+    {
+        if (posix_memalign(&p, std::max(alignment, sizeof(void*)), size) != 0)
+        {
+            p = nullptr;
+        }
+    }
+    else
+    {
+        p = malloc(size);
+    }
+#endif
+    if (p)
+    {
+        Zest::Profiler::TrackAlloc(AllocationSize(p, alignment));
+    }
+    return p;
+}
+
+void TrackedFree(void* p, size_t alignment = 0)
+{
+    if (!p)
+    {
+        return;
+    }
+    Zest::Profiler::TrackFree(AllocationSize(p, alignment));
+#if defined(_WIN32)
+    alignment ? _aligned_free(p) : free(p);
+#else
+    free(p);
+#endif
+}
+
+void* TrackedNew(size_t size, size_t alignment = 0)
+{
+    if (auto p = TrackedMalloc(size, alignment))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    return TrackedNew(size);
+}
+
+void* operator new[](size_t size)
+{
+    return TrackedNew(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedMalloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return TrackedMalloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return TrackedNew(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return TrackedNew(size, size_t(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return TrackedMalloc(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return TrackedMalloc(size, size_t(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    TrackedFree(p);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    TrackedFree(p, size_t(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    TrackedFree(p, size_t(alignment));
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept
+{
+    TrackedFree(p, size_t(alignment));
+}
+
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept
+{
+    TrackedFree(p, size_t(alignment));
+}
+#endif // ZEST_PROFILE_MEMORY
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <atomic>
+#include <catch.hpp>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zest/time/profiler.h>
+
+using namespace Zest;
+
+TEST_CASE("ProfilerPacing", "Time")
+{
+    // A 1ms frame, on time but for one frame that starts a whole period late and runs long
+    const int64_t Period = 1000000;
+    std::vector<glm::i64vec2> spans;
+    for (int64_t frame = 0; frame <= 20; frame++)
+    {
+        auto start = (frame < 10 ? frame : frame + 1) * Period;
+        spans.emplace_back(start, start + (frame == 10 ? Period + Period / 5 : Period / 2));
+    }
+
+    auto stats = Profiler::AnalyzePacing(spans, Period, 4);
+    REQUIRE(stats.intervals == 20);
+    REQUIRE(stats.period == Period);
+    REQUIRE(stats.minInterval == Period);
+    REQUIRE(stats.maxInterval == 2 * Period);
+    REQUIRE(stats.maxDeviation == Period);
+    REQUIRE(stats.missedDeadlines == 1);
+    REQUIRE(stats.overruns == 1);
+
+    // 19 intervals 0.05ms under the mean of 1.05ms, one 0.95ms over
+    REQUIRE(stats.meanInterval == Approx(1.05 * Period));
+    REQUIRE(stats.jitter == Approx(std::sqrt((19 * 0.05 * 0.05 + 0.95 * 0.95) / 20.0) * Period));
+
+    // The late interval lands in the last bucket, on its own
+    REQUIRE(stats.histogram == std::vector<uint32_t>{ 19, 0, 0, 1 });
+    REQUIRE(stats.histogramStart == Period);
+
+    // Without a target the mean stands in, and nothing counts as missed
+    auto free = Profiler::AnalyzePacing(spans, 0, 4);
+    REQUIRE(free.period == int64_t(free.meanInterval));
+    REQUIRE(free.missedDeadlines == 0);
+    REQUIRE(free.overruns == 0);
+
+    REQUIRE(Profiler::AnalyzePacing({ glm::i64vec2(0, 1) }, Period).intervals == 0);
+}
+
+namespace
+{
+
+const char* MixSection = "Mix";
+const char* DecodeSection = "Decode";
+const char* OtherSection = "Other";
+
+void AddEntry(Profiler::ThreadData& thread, const char* szSection, int64_t start, int64_t end, std::initializer_list<Profiler::ProfileArg> args = {})
+{
+    Profiler::ProfilerEntry entry{};
+    entry.szSection = szSection;
+    entry.startTime = start;
+    entry.endTime = end;
+    entry.firstArg = uint32_t(thread.args.size());
+    entry.argCount = uint32_t(args.size());
+    thread.args.insert(thread.args.end(), args.begin(), args.end());
+    thread.entries.push_back(entry);
+    thread.currentEntry++;
+    thread.maxTime = 1000;
+}
+
+} // namespace
+
+TEST_CASE("ProfilerSearch", "Time")
+{
+    Profiler::ProfileSettings settings;
+    settings.MaxThreads = 4;
+    settings.MaxEntriesPerThread = 64;
+    settings.MaxFrames = 16;
+    settings.MaxRegions = 16;
+    Profiler::SetProfileSettings(settings);
+
+    // Two threads with matches, one hidden and one unused; the last Mix on thread 1 is still open
+    auto data = std::make_shared<Profiler::ProfilerData>();
+    data->threadData.resize(4);
+    auto& audio = data->threadData[0];
+    AddEntry(audio, MixSection, 100, 150);
+    AddEntry(audio, OtherSection, 120, 130);
+    AddEntry(audio, MixSection, 300, 400);
+    AddEntry(audio, MixSection, 700, 710);
+
+    auto& worker = data->threadData[1];
+    AddEntry(worker, DecodeSection, 50, 60, { { "mixes", 3 } });
+    AddEntry(worker, MixSection, 200, 500);
+    AddEntry(worker, MixSection, 300, 320);
+    AddEntry(worker, MixSection, 900, std::numeric_limits<int64_t>::max());
+
+    auto& hidden = data->threadData[2];
+    AddEntry(hidden, MixSection, 10, 990);
+    hidden.hidden = true;
+
+    for (uint32_t threadIndex = 0; threadIndex < 3; threadIndex++)
+    {
+        data->threadData[threadIndex].initialized = true;
+    }
+    Profiler::UnDump(data);
+
+    // Indexing stops at the budget and picks up where it left off
+    REQUIRE(Profiler::Search("mix", 2) == 1);
+    REQUIRE(Profiler::IsSearchIndexing());
+
+    // Section names match in any case, and arg names match too; hidden threads don't count
+    REQUIRE(Profiler::Search("mix") == 7);
+    REQUIRE_FALSE(Profiler::IsSearchIndexing());
+    REQUIRE(Profiler::Search("MIX") == 7);
+    REQUIRE(Profiler::Search("other") == 1);
+
+    // Steps go by start time, then thread, across both threads
+    REQUIRE(Profiler::Search("mix") == 7);
+    Profiler::SearchResult result;
+    REQUIRE(Profiler::SearchStep(true, result));
+    while (Profiler::SearchStep(false, result))
+    {
+    }
+
+    std::vector<std::pair<uint32_t, int64_t>> order;
+    do
+    {
+        order.emplace_back(result.threadIndex, data->threadData[result.threadIndex].entries[result.entryIndex].startTime);
+    } while (Profiler::SearchStep(true, result));
+    REQUIRE(order == std::vector<std::pair<uint32_t, int64_t>>{ { 1, 50 }, { 0, 100 }, { 1, 200 }, { 0, 300 }, { 1, 300 }, { 0, 700 }, { 1, 900 } });
+
+    REQUIRE(Profiler::SearchStep(false, result));
+    REQUIRE(result.threadIndex == 0);
+    REQUIRE(result.entryIndex == 3);
+
+    // Longest first; the open entry runs to the end of the capture
+    auto slowest = Profiler::SearchSlowest(3);
+    REQUIRE(slowest.size() == 3);
+    REQUIRE(slowest[0].threadIndex == 1);
+    REQUIRE(slowest[0].entryIndex == 1);
+    REQUIRE(slowest[0].duration == 300);
+    REQUIRE(slowest[1].duration == 100);
+    REQUIRE(slowest[2].duration == 100);
+    REQUIRE(Profiler::SearchSlowest(20).size() == 7);
+
+    REQUIRE(Profiler::Search("nothing") == 0);
+    REQUIRE_FALSE(Profiler::SearchStep(true, result));
+}
+
+TEST_CASE("ProfilerMarksAndArgs", "Time")
+{
+    Profiler::ProfileSettings settings;
+    settings.MaxThreads = 4;
+    settings.MaxEntriesPerThread = 64;
+    settings.MaxFrames = 16;
+    settings.MaxRegions = 16;
+    settings.MaxArgsPerThread = 4;
+    Profiler::SetProfileSettings(settings);
+
+    {
+        PROFILE_SCOPE_ARGS(Batch, { "batch", 512 }, { "gain", 0.5f });
+        PROFILE_MARK_ARGS(Hit, { "frames", 12 });
+
+        // Only one arg slot is left, so these are dropped; the scope is still recorded
+        PROFILE_SCOPE_ARGS(Overflow, { "a", 1 }, { "b", 2 });
+    }
+    PROFILE_MARK(Done);
+
+    // Stop the capture to read it
+    auto data = Profiler::GetProfilerData();
+    Profiler::UnDump(data);
+
+    auto itrThread = std::find_if(data->threadData.begin(), data->threadData.end(), [](const Profiler::ThreadData& thread) {
+        return thread.currentEntry > 0;
+    });
+    REQUIRE(itrThread != data->threadData.end());
+    const auto& thread = *itrThread;
+    REQUIRE(thread.currentEntry == 4);
+    REQUIRE(thread.currentArg == 3);
+
+    const auto& batch = thread.entries[0];
+    REQUIRE(std::string(batch.szSection) == "Batch");
+    REQUIRE(batch.firstArg == 0);
+    REQUIRE(batch.argCount == 2);
+    REQUIRE((batch.flags & Profiler::EntryFlags_Mark) == 0);
+    REQUIRE(batch.endTime >= batch.startTime);
+    REQUIRE(Profiler::FormatArgs(thread, batch) == "batch=512 gain=0.5");
+
+    // A zero length child of the open scope
+    const auto& hit = thread.entries[1];
+    REQUIRE(std::string(hit.szSection) == "Hit");
+    REQUIRE(hit.flags & Profiler::EntryFlags_Mark);
+    REQUIRE(hit.startTime == hit.endTime);
+    REQUIRE(hit.parent == 0);
+    REQUIRE(hit.level == 1);
+    REQUIRE(hit.firstArg == 2);
+    REQUIRE(hit.argCount == 1);
+    REQUIRE(Profiler::FormatArgs(thread, hit) == "frames=12");
+
+    const auto& overflow = thread.entries[2];
+    REQUIRE(std::string(overflow.szSection) == "Overflow");
+    REQUIRE(overflow.argCount == 0);
+    REQUIRE(Profiler::FormatArgs(thread, overflow).empty());
+
+    const auto& done = thread.entries[3];
+    REQUIRE(done.flags & Profiler::EntryFlags_Mark);
+    REQUIRE(done.level == 0);
+    REQUIRE(done.argCount == 0);
+}
+
+TEST_CASE("ProfilerInstrumentFilters", "Time")
+{
+    // No filters lets everything through
+    Profiler::InstrumentClearFilters();
+    REQUIRE(Profiler::InstrumentFilterAccepts(0x1234));
+
+    Profiler::InstrumentAddressRange(0x1000, 0x2000);
+    Profiler::InstrumentAddressRange(0x8000, 0x9000);
+    REQUIRE(Profiler::InstrumentFilterAccepts(0x1000));
+    REQUIRE(Profiler::InstrumentFilterAccepts(0x1fff));
+    REQUIRE(!Profiler::InstrumentFilterAccepts(0x2000));
+    REQUIRE(!Profiler::InstrumentFilterAccepts(0x0fff));
+    REQUIRE(Profiler::InstrumentFilterAccepts(0x8800));
+
+    Profiler::InstrumentClearFilters();
+    REQUIRE(Profiler::InstrumentFilterAccepts(0x2000));
+
+    // Hooks keep reading while the filters are cleared and refilled; the ranges here always include the address
+    std::atomic<bool> stop = false;
+    std::atomic<uint32_t> rejected = 0;
+    std::thread hook([&]() {
+        while (!stop)
+        {
+            if (!Profiler::InstrumentFilterAccepts(0x1800))
+            {
+                rejected++;
+            }
+        }
+    });
+    for (int i = 0; i < 10000; i++)
+    {
+        Profiler::InstrumentClearFilters();
+        Profiler::InstrumentAddressRange(0x1000, 0x2000);
+    }
+    stop = true;
+    hook.join();
+    REQUIRE(rejected == 0);
+
+    Profiler::InstrumentClearFilters();
+}
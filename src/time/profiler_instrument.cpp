@@ -0,0 +1,292 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <zest/thread/thread_utils.h>
+#include <zest/time/profiler.h>
+
+#if defined(ZEST_PROFILE_INSTRUMENT) && !defined(_MSC_VER)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+#if defined(__linux__)
+#include <link.h>
+#endif
+
+// Routes -finstrument-functions hooks into the profiler.
+// Targets are compiled with the flag using zest_instrument_target() (cmake/utils.cmake); this file
+// and the rest of Zest are not, so the profiler doesn't profile itself.
+// Function names are resolved the first time a function is seen, through a shared site table, and
+// cached per thread after that. Filters limit recording to address ranges (or whole modules), which
+// is the way to keep the overhead bounded in large programs.
+namespace Zest
+{
+
+namespace Profiler
+{
+
+namespace
+{
+
+// Slots are reused after a clear while hooks on other threads may still be reading them, so they are atomic.
+// A hook racing a filter change can see a half written range and misjudge that one call, but never reads a torn value
+struct AddressRange
+{
+    std::atomic<uintptr_t> begin = 0;
+    std::atomic<uintptr_t> end = 0;
+};
+
+const uint32_t MaxAddressRanges = 64;
+std::array<AddressRange, MaxAddressRanges> gAddressRanges;
+std::atomic<uint32_t> gAddressRangeCount = 0;
+std::mutex gFilterMutex;
+
+bool AddAddressRange(uintptr_t begin, uintptr_t end)
+{
+    auto count = gAddressRangeCount.load();
+    if (count >= MaxAddressRanges)
+    {
+        return false;
+    }
+
+    // Write the range before publishing it to the hooks
+    gAddressRanges[count].begin.store(begin, std::memory_order_relaxed);
+    gAddressRanges[count].end.store(end, std::memory_order_relaxed);
+    gAddressRangeCount.store(count + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace
+
+void InstrumentAddressRange(uintptr_t begin, uintptr_t end)
+{
+    std::lock_guard<std::mutex> lock(gFilterMutex);
+    AddAddressRange(begin, end);
+}
+
+// Record functions in the loaded module(s) whose path contains the name
+bool InstrumentModule(const char* pszModuleName)
+{
+#if defined(__linux__)
+    std::lock_guard<std::mutex> lock(gFilterMutex);
+
+    struct ModuleSearch
+    {
+        const char* pszName;
+        bool found;
+    } search{ pszModuleName, false };
+
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+        auto pSearch = (ModuleSearch*)data;
+        if (!info->dlpi_name || !strstr(info->dlpi_name, pSearch->pszName))
+        {
+            return 0;
+        }
+
+        // Executable segments only
+        for (int header = 0; header < info->dlpi_phnum; header++)
+        {
+            const auto& phdr = info->dlpi_phdr[header];
+            if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X))
+            {
+                auto begin = uintptr_t(info->dlpi_addr + phdr.p_vaddr);
+                pSearch->found |= AddAddressRange(begin, begin + phdr.p_memsz);
+            }
+        }
+        return 0;
+    },
+        &search);
+    return search.found;
+#else
+    (void)pszModuleName;
+    return false;
+#endif
+}
+
+void InstrumentClearFilters()
+{
+    std::lock_guard<std::mutex> lock(gFilterMutex);
+    gAddressRangeCount.store(0, std::memory_order_release);
+}
+
+// Called from the hooks on every instrumented call, so no locks
+bool InstrumentFilterAccepts(uintptr_t address)
+{
+    auto count = gAddressRangeCount.load(std::memory_order_acquire);
+    if (count == 0)
+    {
+        return true;
+    }
+
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const auto& range = gAddressRanges[index];
+        if (address >= range.begin.load(std::memory_order_relaxed) && address < range.end.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Profiler
+} // namespace Zest
+
+#if defined(ZEST_PROFILE_INSTRUMENT) && !defined(_MSC_VER)
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+namespace
+{
+
+using namespace Zest;
+using namespace Zest::Profiler;
+
+struct InstrumentSite
+{
+    const char* szName;
+    const char* szFile;
+    uint32_t color;
+};
+
+// Shared between threads; names live in a deque so the pointers handed to the profiler never move
+struct SiteTable
+{
+    spin_mutex mutex;
+    std::unordered_map<void*, InstrumentSite> sites;
+    std::deque<std::string> strings;
+};
+
+// Hooks run during static construction/destruction, so the table is created on first use and never freed
+NO_INSTRUMENT SiteTable& GetSiteTable()
+{
+    static auto pTable = new SiteTable();
+    return *pTable;
+}
+
+// The hooks can be re-entered by instrumented inline code (std containers, etc.) that they call
+thread_local bool gInHookTLS = false;
+thread_local std::unordered_map<void*, InstrumentSite>* gSiteCacheTLS = nullptr;
+
+// Remembers which frames were pushed, so exit matches enter even if the filters change
+const uint32_t MaxTrackedDepth = 256;
+thread_local uint32_t gDepthTLS = 0;
+thread_local uint64_t gPushedTLS[MaxTrackedDepth / 64];
+
+NO_INSTRUMENT const InstrumentSite& ResolveSite(void* fn)
+{
+    if (!gSiteCacheTLS)
+    {
+        gSiteCacheTLS = new std::unordered_map<void*, InstrumentSite>();
+    }
+
+    auto itrCached = gSiteCacheTLS->find(fn);
+    if (itrCached != gSiteCacheTLS->end())
+    {
+        return itrCached->second;
+    }
+
+    auto& table = GetSiteTable();
+    spin_mutex_lock lock(table.mutex);
+    auto itrSite = table.sites.find(fn);
+    if (itrSite == table.sites.end())
+    {
+        std::string name;
+        std::string file = "?";
+
+        Dl_info info;
+        if (dladdr(fn, &info))
+        {
+            if (info.dli_sname)
+            {
+                int status = 0;
+                auto pszDemangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                name = (status == 0 && pszDemangled) ? pszDemangled : info.dli_sname;
+                free(pszDemangled);
+            }
+            if (info.dli_fname)
+            {
+                file = info.dli_fname;
+            }
+        }
+
+        if (name.empty())
+        {
+            char address[32];
+            snprintf(address, sizeof(address), "0x%llx", (unsigned long long)uintptr_t(fn));
+            name = address;
+        }
+
+        InstrumentSite site;
+        site.szName = table.strings.emplace_back(name).c_str();
+        site.szFile = table.strings.emplace_back(file).c_str();
+        site.color = ToPackedARGB(ColorFromName(site.szName, uint32_t(strlen(site.szName))));
+        itrSite = table.sites.emplace(fn, site).first;
+    }
+
+    return gSiteCacheTLS->emplace(fn, itrSite->second).first->second;
+}
+
+} // namespace
+
+extern "C" {
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void* fn, void* callSite)
+{
+    (void)callSite;
+    if (gInHookTLS)
+    {
+        return;
+    }
+    gInHookTLS = true;
+
+    auto depth = gDepthTLS++;
+    bool push = !IsPaused() && InstrumentFilterAccepts(uintptr_t(fn));
+    if (depth < MaxTrackedDepth)
+    {
+        auto& bits = gPushedTLS[depth / 64];
+        auto bit = uint64_t(1) << (depth % 64);
+        bits = push ? (bits | bit) : (bits & ~bit);
+    }
+    else
+    {
+        push = false;
+    }
+
+    if (push)
+    {
+        const auto& site = ResolveSite(fn);
+        PushSectionBase(site.szName, site.color, site.szFile, 0);
+    }
+
+    gInHookTLS = false;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void* fn, void* callSite)
+{
+    (void)fn;
+    (void)callSite;
+    if (gInHookTLS || gDepthTLS == 0)
+    {
+        return;
+    }
+    gInHookTLS = true;
+
+    auto depth = --gDepthTLS;
+    if (depth < MaxTrackedDepth && (gPushedTLS[depth / 64] & (uint64_t(1) << (depth % 64))))
+    {
+        PopSection();
+    }
+
+    gInHookTLS = false;
+}
+
+} // extern "C"
+
+#endif // ZEST_PROFILE_INSTRUMENT
@@ -21,6 +21,9 @@ TimeProvider& TimeProvider::Instance()
 TimeProvider::TimeProvider()
 {
     m_startTime = Now();
+    m_snapshot.update([&](auto& snapshot) {
+        snapshot.time = m_startTime;
+    });
     SetTempo(120.0, 4.0);
 }
 
@@ -46,13 +49,13 @@ void TimeProvider::ResetStartTime()
 
 void TimeProvider::RegisterConsumer(ITimeConsumer* pConsumer)
 {
-    LOCK_GUARD(m_spin_mutex, TP_Lock);
+    LOCK_GUARD(m_mutex, TP_Lock);
     m_consumers.insert(pConsumer);
 }
 
 void TimeProvider::UnRegisterConsumer(ITimeConsumer* pConsumer)
 {
-    LOCK_GUARD(m_spin_mutex, TP_Lock);
+    LOCK_GUARD(m_mutex, TP_Lock);
     m_consumers.erase(pConsumer);
 }
 
@@ -69,16 +72,18 @@ void TimeProvider::StartThread()
 
             // Beat at regular intervals, no matter how long our operation takes
             auto startTime = TimeProvider::Instance().Now();
-            auto nextTime = startTime + m_timePerBeat;
+            auto nextTime = startTime + m_snapshot.load().timePerBeat;
             auto beat = m_beat.load();
             auto frame = m_frame.load();
 
             {
                 PROFILE_SCOPE(TP_Beat);
-                LOCK_GUARD(m_spin_mutex, TP_Lock);
+                LOCK_GUARD(m_mutex, TP_Lock);
 
-                m_lastTime = startTime;
-                m_lastBeat = beat;
+                m_snapshot.update([&](auto& snapshot) {
+                    snapshot.time = startTime;
+                    snapshot.beat = beat;
+                });
 
                 for (auto& consumer : m_consumers)
                 {
@@ -108,13 +113,14 @@ void TimeProvider::EndThread()
     }
 }
 
-double TimeProvider::GetBeatAtTime(TimePoint time)
+double TimeProvider::GetBeatAtTime(TimePoint time) const
 {
-    auto d = duration_cast<microseconds>(time - m_lastTime).count();
-    auto beat = m_lastBeat.load();
+    // Time, beat and tempo from the same tick
+    auto snapshot = m_snapshot.load();
+    auto d = duration_cast<microseconds>(time - snapshot.time).count();
 
-    auto beatsPerTime = (double)d / (double)duration_cast<microseconds>(GetTimePerBeat()).count();
-    return beat + beatsPerTime;
+    auto beatsPerTime = (double)d / (double)snapshot.timePerBeat.count();
+    return snapshot.beat + beatsPerTime;
 }
 
 // TODO:
@@ -138,21 +144,24 @@ double TimeProvider::GetQuantum() const
 
 void TimeProvider::SetTempo(double tempo, double quantum)
 {
-    LOCK_GUARD(m_spin_mutex, TP_Lock);
+    LOCK_GUARD(m_mutex, TP_Lock);
     m_quantum = quantum;
     m_tempo = tempo;
-    m_timePerBeat = microseconds((uint64_t)(60000000.0 / tempo));
+    m_snapshot.update([&](auto& snapshot) {
+        snapshot.tempo = tempo;
+        snapshot.timePerBeat = microseconds((uint64_t)(60000000.0 / tempo));
+    });
 }
 
 void TimeProvider::SetBeat(double beat)
 {
-    LOCK_GUARD(m_spin_mutex, TP_Lock);
+    LOCK_GUARD(m_mutex, TP_Lock);
     m_beat = beat;
 }
 
 void TimeProvider::SetFrame(uint32_t frame)
 {
-    LOCK_GUARD(m_spin_mutex, TP_Lock);
+    LOCK_GUARD(m_mutex, TP_Lock);
     m_frame.store(frame);
 }
 
@@ -163,7 +172,12 @@ uint32_t TimeProvider::GetFrame() const
 
 std::chrono::microseconds TimeProvider::GetTimePerBeat() const
 {
-    return m_timePerBeat;
+    return m_snapshot.load().timePerBeat;
+}
+
+TimeSnapshot TimeProvider::GetSnapshot() const
+{
+    return m_snapshot.load();
 }
 
 } // namespace Zest